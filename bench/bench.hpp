@@ -0,0 +1,127 @@
+#ifndef __GLW_BENCH_HPP
+#define __GLW_BENCH_HPP
+
+// Microbenchmarks of the wrappers against the raw GL calls they make. Each
+// bench/*.cpp builds like a test, on any backend of test/test.hpp, e.g.
+//
+//   g++ -std=c++11 -O2 -DNDEBUG -D__GLW_TEST_EGL -I. -Itest bench/program.cpp -lGLEW -lEGL -lGL
+//
+// and prints one JSON document to stdout:
+//
+//   { "benchmark": "program", "backend": "egl", "renderer": "llvmpipe ...",
+//     "results": [ { "name": "draw", "variant": "gl", "parameter": 0,
+//       "iterations": 262143, "seconds": 0.25, "ops_per_second": 1.0e6,
+//       "bytes_per_second": 0 }, ... ] }
+//
+// Variants are "gl" for the raw baseline, "glw" for the default error
+// policy and "glw_check_never" for glw::CheckNever. Built with
+// -D__GLW_ENABLE_PROFILER, the glw variants are reported as "glw_profiler"
+// and "glw_check_never_profiler" to measure the cost of __GLW_PROFILE.
+// GLW_BENCH_SECONDS sets the minimum time per case, 0.25 by default.
+
+#include "test.hpp"
+
+#include <chrono>
+#include <string>
+
+class Bench
+{
+private:
+    struct Result
+    {
+        std::string name;
+        std::string variant;
+        long parameter;
+        size_t iterations;
+        double seconds;
+        double bytes;
+    };
+
+    std::string benchmark_;
+    std::vector<Result> results_;
+    double min_seconds_;
+    bool failed_;
+
+    static std::string quote(const char* text__)
+    {
+        std::string result = "\"";
+        for(; text__ && *text__; ++text__) {
+            if(*text__ == '"' || *text__ == '\\') result += '\\';
+            if((unsigned char)*text__ >= 0x20) result += *text__;
+        }
+        return result + "\"";
+    }
+
+public:
+    Bench(const char* benchmark__)
+      : benchmark_(benchmark__),
+        min_seconds_(0.25),
+        failed_(false)
+    {
+        TEST_INIT();
+        const char* seconds = getenv("GLW_BENCH_SECONDS");
+        if(seconds && atof(seconds) > 0.0) min_seconds_ = atof(seconds);
+    }
+
+    // Times op__, which returns a GL error code, in doubling batches until
+    // min_seconds_ have passed. Each batch ends with glFinish so that the
+    // GPU work is counted.
+    template <typename Op>
+    void run(
+        const char* name__,
+        const char* variant__,
+        const long parameter__,
+        const size_t bytes__,
+        Op op__)
+    {
+        typedef std::chrono::steady_clock Clock;
+        if(op__() != GL_NO_ERROR) failed_ = true;
+        glFinish();
+
+        size_t iterations = 0;
+        size_t batch = 1;
+        double seconds = 0.0;
+        const Clock::time_point start = Clock::now();
+        while(seconds < min_seconds_) {
+            for(size_t i = 0; i < batch; ++i) {
+                if(op__() != GL_NO_ERROR) failed_ = true;
+            }
+            glFinish();
+            iterations += batch;
+            batch *= 2;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        Result result = { name__, variant__, parameter__, iterations, seconds, (double)bytes__ * iterations };
+#ifdef __GLW_ENABLE_PROFILER
+        if(result.variant != "gl") result.variant += "_profiler";
+#endif
+        results_.push_back(result);
+    }
+
+    // Prints the results, and fails if any operation did.
+    int report() const
+    {
+        printf("{\n  \"benchmark\": %s,\n", quote(benchmark_.c_str()).c_str());
+        printf("  \"backend\": %s,\n", quote(test_backend()).c_str());
+        printf("  \"renderer\": %s,\n", quote((const char*)glGetString(GL_RENDERER)).c_str());
+        printf("  \"results\": [\n");
+        for(size_t i = 0; i < results_.size(); ++i) {
+            const Result& r = results_[i];
+            printf("    { \"name\": %s, \"variant\": %s, \"parameter\": %ld, \"iterations\": %zu, "
+                "\"seconds\": %.6f, \"ops_per_second\": %.1f, \"bytes_per_second\": %.1f }%s\n",
+                quote(r.name.c_str()).c_str(),
+                quote(r.variant.c_str()).c_str(),
+                r.parameter,
+                r.iterations,
+                r.seconds,
+                r.iterations / r.seconds,
+                r.bytes / r.seconds,
+                i + 1 < results_.size() ? "," : "");
+        }
+        printf("  ]\n}\n");
+        if(failed_) fprintf(stderr, "bench: an operation failed\n");
+        return failed_ ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+};
+
+#endif
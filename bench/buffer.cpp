@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include "glw_buffer.hpp"
+
+static const size_t sizes[] = { 4 << 10, 64 << 10, 1 << 20, 16 << 20 };
+
+template <class ErrorPolicy>
+void bench_glw(Bench& bench, const char* variant, std::vector<GLubyte>& data)
+{
+    glw::StateCache::current().invalidate();
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        const size_t size = sizes[i];
+        glw::BasicBuffer<ErrorPolicy> buffer(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW, size, NULL);
+        bench.run("write", variant, size, size, [&]() {
+            return buffer.write(0, size, &data[0]);
+        });
+        bench.run("read", variant, size, size, [&]() {
+            return buffer.read(0, size, &data[0]);
+        });
+    }
+}
+
+// The baseline makes the calls glw does: the buffer is bound once, as
+// StateCache skips binding it again, and reads map, copy and unmap it.
+void bench_gl(Bench& bench, std::vector<GLubyte>& data)
+{
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        const size_t size = sizes[i];
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        bench.run("write", "gl", size, size, [&]() {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, &data[0]);
+            return (GLuint)GL_NO_ERROR;
+        });
+        bench.run("read", "gl", size, size, [&]() {
+            const void* mem = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_READ_BIT);
+            if(!mem) return (GLuint)GL_INVALID_OPERATION;
+            memcpy(&data[0], mem, size);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            return (GLuint)GL_NO_ERROR;
+        });
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+int main()
+{
+    Bench bench("buffer");
+    std::vector<GLubyte> data(sizes[sizeof(sizes) / sizeof(sizes[0]) - 1], 0x5a);
+
+    bench_gl(bench, data);
+    bench_glw<glw::DefaultErrorPolicy>(bench, "glw", data);
+    bench_glw<glw::CheckNever>(bench, "glw_check_never", data);
+
+    return bench.report();
+}
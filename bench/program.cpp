@@ -0,0 +1,165 @@
+#include "bench.hpp"
+#include "glw_program.hpp"
+
+#include <sstream>
+
+static const GLint uniform_counts[] = { 1, 16, 64 };
+
+// Vertex shader reading count vec4 uniforms u_0 to u_<count - 1>.
+static std::string vertex_source(const GLint count)
+{
+    std::ostringstream source;
+    source << "#version 330\nin vec2 v_position;\n";
+    for(GLint i = 0; i < count; ++i) source << "uniform vec4 u_" << i << ";\n";
+    source << "void main() { vec4 sum = vec4(0);";
+    for(GLint i = 0; i < count; ++i) source << " sum += u_" << i << ";";
+    source << " gl_Position = vec4(v_position, 0, 1) + sum; }\n";
+    return source.str();
+}
+
+static const char* fragment_source =
+    "#version 330\n"
+    "out vec4 f_color;"
+    "void main() { f_color = vec4(1); }";
+
+static std::string uniform_name(const GLint index)
+{
+    std::ostringstream name;
+    name << "u_" << index;
+    return name.str();
+}
+
+// Draws are single degenerate triangles, so the CPU cost of issuing them
+// dominates.
+template <class ErrorPolicy>
+void bench_glw(Bench& bench, const char* variant, const GLuint buffers[2])
+{
+    glw::StateCache::current().invalidate();
+    for(size_t i = 0; i < sizeof(uniform_counts) / sizeof(uniform_counts[0]); ++i) {
+        const GLint count = uniform_counts[i];
+        const std::string vsource = vertex_source(count);
+        typename glw::BasicProgram<ErrorPolicy>::Shaders shaders = {
+            { GL_VERTEX_SHADER, vsource.c_str() },
+            { GL_FRAGMENT_SHADER, fragment_source } };
+        glw::BasicProgram<ErrorPolicy> program(shaders);
+        if(program.build() != GL_NO_ERROR) {
+            fprintf(stderr, "bench: %s\n", program.log().c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        std::vector<typename glw::BasicProgram<ErrorPolicy>::UniformHandle> uniforms;
+        for(GLint j = 0; j < count; ++j) {
+            uniforms.push_back(program.uniformHandle(uniform_name(j).c_str()));
+        }
+        const typename glw::BasicProgram<ErrorPolicy>::AttributeHandle position = program.attributeHandle("v_position");
+        program.setAttribute(position, buffers[0]);
+
+        bench.run("draw", variant, count, 0, [&]() {
+            return program.execute(GL_TRIANGLES, 0, 3);
+        });
+
+        GLfloat value = 0.0f;
+        bench.run("set_uniform", variant, count, 0, [&]() {
+            value += 1.0f;
+            const GLfloat vector[4] = { value, value, value, value };
+            GLuint error;
+            for(GLint j = 0; j < count; ++j) {
+                if((error = program.setUniform(uniforms[j], vector)) != GL_NO_ERROR) return error;
+            }
+            return program.execute(GL_TRIANGLES, 0, 3);
+        });
+
+        size_t frame = 0;
+        bench.run("set_attribute", variant, count, 0, [&]() {
+            GLuint error;
+            if((error = program.setAttribute(position, buffers[++frame % 2])) != GL_NO_ERROR) return error;
+            return program.execute(GL_TRIANGLES, 0, 3);
+        });
+    }
+}
+
+void bench_gl(Bench& bench, const GLuint buffers[2])
+{
+    for(size_t i = 0; i < sizeof(uniform_counts) / sizeof(uniform_counts[0]); ++i) {
+        const GLint count = uniform_counts[i];
+        const std::string vsource = vertex_source(count);
+        const char* sources[2] = { vsource.c_str(), fragment_source };
+        const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+        const GLuint program = glCreateProgram();
+        for(int j = 0; j < 2; ++j) {
+            const GLuint shader = glCreateShader(types[j]);
+            glShaderSource(shader, 1, &sources[j], NULL);
+            glCompileShader(shader);
+            glAttachShader(program, shader);
+            glDeleteShader(shader);
+        }
+        glLinkProgram(program);
+
+        std::vector<GLint> uniforms;
+        for(GLint j = 0; j < count; ++j) {
+            uniforms.push_back(glGetUniformLocation(program, uniform_name(j).c_str()));
+        }
+        const GLint position = glGetAttribLocation(program, "v_position");
+        GLuint vertex_array;
+        glGenVertexArrays(1, &vertex_array);
+        glBindVertexArray(vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        glEnableVertexAttribArray(position);
+        glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+        bench.run("draw", "gl", count, 0, [&]() {
+            glUseProgram(program);
+            glBindVertexArray(vertex_array);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            return (GLuint)GL_NO_ERROR;
+        });
+
+        GLfloat value = 0.0f;
+        bench.run("set_uniform", "gl", count, 0, [&]() {
+            value += 1.0f;
+            const GLfloat vector[4] = { value, value, value, value };
+            glUseProgram(program);
+            for(GLint j = 0; j < count; ++j) {
+                glUniform4fv(uniforms[j], 1, vector);
+            }
+            glBindVertexArray(vertex_array);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            return (GLuint)GL_NO_ERROR;
+        });
+
+        size_t frame = 0;
+        bench.run("set_attribute", "gl", count, 0, [&]() {
+            glUseProgram(program);
+            glBindVertexArray(vertex_array);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[++frame % 2]);
+            glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, 0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            return (GLuint)GL_NO_ERROR;
+        });
+
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &vertex_array);
+        glUseProgram(0);
+        glDeleteProgram(program);
+    }
+}
+
+int main()
+{
+    Bench bench("program");
+
+    const GLfloat vertices[2 * 3] = { 0 };
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    for(int i = 0; i < 2; ++i) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    }
+
+    bench_gl(bench, buffers);
+    bench_glw<glw::DefaultErrorPolicy>(bench, "glw", buffers);
+    bench_glw<glw::CheckNever>(bench, "glw_check_never", buffers);
+
+    glDeleteBuffers(2, buffers);
+    return bench.report();
+}
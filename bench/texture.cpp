@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include "glw_texture.hpp"
+
+static const GLint sizes[] = { 64, 256, 1024 };
+
+template <class ErrorPolicy>
+void bench_glw(Bench& bench, const char* variant, std::vector<GLubyte>& data)
+{
+    const glw::ImageFormat format = { GL_UNSIGNED_BYTE, GL_RGBA };
+    glw::StateCache::current().invalidate();
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        const GLint size = sizes[i];
+        const size_t bytes = size * size * 4;
+        glw::BasicTexture2D<ErrorPolicy> texture(GL_RGBA8, 1, size, size);
+        bench.run("upload", variant, size, bytes, [&]() {
+            return texture.write(0, format, 0, 0, size, size, &data[0]);
+        });
+        bench.run("readback", variant, size, bytes, [&]() {
+            return texture.read(0, format, 0, 0, size, size, &data[0]);
+        });
+    }
+}
+
+void bench_gl(Bench& bench, std::vector<GLubyte>& data)
+{
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        const GLint size = sizes[i];
+        const size_t bytes = size * size * 4;
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, size, size);
+        bench.run("upload", "gl", size, bytes, [&]() {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+            return (GLuint)GL_NO_ERROR;
+        });
+        bench.run("readback", "gl", size, bytes, [&]() {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+            return (GLuint)GL_NO_ERROR;
+        });
+        glDeleteTextures(1, &texture);
+    }
+}
+
+int main()
+{
+    Bench bench("texture");
+    std::vector<GLubyte> data(sizes[sizeof(sizes) / sizeof(sizes[0]) - 1] * sizes[sizeof(sizes) / sizeof(sizes[0]) - 1] * 4, 0x5a);
+
+    bench_gl(bench, data);
+    bench_glw<glw::DefaultErrorPolicy>(bench, "glw", data);
+    bench_glw<glw::CheckNever>(bench, "glw_check_never", data);
+
+    return bench.report();
+}
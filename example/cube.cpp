@@ -32,6 +32,18 @@ static const char* f_shader =
 //    "   gl_Color += vec4(f_texcoord.x, f_texcoord.y, 0, 1);"
     "}";
 
+struct Vertex
+{
+    float position[3];
+    float texcoord[2];
+};
+
+typedef glw::VertexLayout<Vertex,
+    __GLW_VERTEX_FIELD(Vertex, position),
+    __GLW_VERTEX_FIELD(Vertex, texcoord)> VertexLayout;
+
+static const GLchar* vertex_names[] = { "v_position", "v_texcoord" };
+
 const float vertices[5*4*2] = {
     // front
     -1, -1, -1, 0, 0, 
@@ -134,8 +146,7 @@ int main()
             // Draw cube.
             program.setSampler("u_sampler", 0, texture());
             program.setUniform("u_mvp", proj*view*model);
-            program.setAttribute("v_position", v_buffer(), 20, 0);
-            program.setAttribute("v_texcoord", v_buffer(), 20, 12);
+            program.setAttributes<VertexLayout>(vertex_names, v_buffer());
             program.execute(GL_TRIANGLES, elements, GL_UNSIGNED_INT, i_buffer());
 
             glfwSwapBuffers(window);
@@ -5,15 +5,21 @@
 
 namespace glw {
 
-class Buffer : public Wrapper
+template <class ErrorPolicy>
+class BasicReadTicket;
+
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicBuffer : public Wrapper
 {
 private:
+    static const GLuint debug_source = SOURCE_BUFFER;
+
     GLenum target_;
     GLenum usage_;
     size_t size_;
 
 public:
-    Buffer(
+    BasicBuffer(
         const GLenum target__,
         const GLenum usage__,
         const size_t size__,
@@ -23,9 +29,10 @@ public:
         usage_(usage__),
         size_(size__)
     {
+        GLuint error;
         __GLW_HANDLE(glGenBuffers(1, &handle_)) {}
-        __GLW_HANDLE(glBindBuffer(target_, *this)) {
-            if(error__) *error__ = handle_error(__GLW_LAST_ERROR, "glBindBuffer");
+        if((error = bind()) != GL_NO_ERROR) {
+            if(error__) *error__ = error;
             return;
         }
         __GLW_HANDLE(glBufferData(target_, size__, data__, usage__)) {
@@ -34,49 +41,141 @@ public:
         }
     }
 
-    ~Buffer()
+    // Immutable storage, see glBufferStorage for flags__.
+    BasicBuffer(
+        const GLenum target__,
+        const size_t size__,
+        const void* data__,
+        const GLbitfield flags__,
+        GLuint* error__ = NULL)
+      : target_(target__),
+        usage_(0),
+        size_(size__)
+    {
+        GLuint error;
+        __GLW_HANDLE(glGenBuffers(1, &handle_)) {}
+        if((error = bind()) != GL_NO_ERROR) {
+            if(error__) *error__ = error;
+            return;
+        }
+        __GLW_HANDLE(glBufferStorage(target_, size__, data__, flags__)) {
+            if(error__) *error__ = handle_error(__GLW_LAST_ERROR, "glBufferStorage");
+            return;
+        }
+    }
+
+    ~BasicBuffer()
     {
-        if(handle_) glDeleteBuffers(1, &handle_);
+        if(handle_) {
+            StateCache::current().forgetBuffer(handle_);
+            glDeleteBuffers(1, &handle_);
+        }
     }
 
     GLuint bind()
     {
-        __GLW_HANDLE(glBindBuffer(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindBuffer");
-        }
+        return StateCache::current().bindBuffer<ErrorPolicy>(target_, handle_);
     }
 
     GLuint write(const GLint offset__, const size_t size__, const void* data__)
     {
-        __GLW_HANDLE(glBindBuffer(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindBuffer");
+        __GLW_PROFILE("Buffer::write");
+        GLuint error;
+        if((error = bind()) != GL_NO_ERROR) {
+            return error;
         }
         __GLW_HANDLE(glBufferSubData(target_, offset__, size__, data__)) {
             return handle_error(__GLW_LAST_ERROR, "glBufferSubData");
         }
+        __GLW_COUNT(bytes_uploaded, size__);
         return GL_NO_ERROR;
     }
 
+    // Maps only the requested range. This still waits for pending GPU
+    // writes to the buffer; see readAsync() for a non-blocking read.
     GLuint read(const GLint offset__, const size_t size__, void* data__)
     {
+        __GLW_PROFILE("Buffer::read");
+        GLuint error = GL_NO_ERROR;
+        void* mem = map(offset__, size__, GL_MAP_READ_BIT, &error);
+        if(!mem) {
+            return error;
+        }
+        memcpy(data__, mem, size__);
+        __GLW_COUNT(bytes_read, size__);
+        return unmap();
+    }
+
+    // Copies [offset, offset + size) into the ticket's staging buffer on the
+    // GPU and returns at once. Poll ticket__.ready() or call
+    // ticket__.read() to fetch the data.
+    GLuint readAsync(
+        const GLint offset__,
+        const size_t size__,
+        BasicReadTicket<ErrorPolicy>& ticket__)
+    {
+        return ticket__.copy(handle_, offset__, size__);
+    }
+
+    void* map(
+        const GLintptr offset__,
+        const GLsizeiptr size__,
+        const GLbitfield access__,
+        GLuint* error__ = NULL)
+    {
+        GLuint error;
         void* mem;
-        __GLW_HANDLE(glBindBuffer(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindBuffer");
+        if((error = bind()) != GL_NO_ERROR) {
+            if(error__) *error__ = error;
+            return NULL;
+        }
+        __GLW_HANDLE(mem = glMapBufferRange(target_, offset__, size__, access__)) {
+            if(error__) *error__ = handle_error(__GLW_LAST_ERROR, "glMapBufferRange");
+            return NULL;
+        }
+        if(!mem && error__) {
+            *error__ = handle_error(GL_INVALID_OPERATION, "glMapBufferRange");
+        }
+        return mem;
+    }
+
+    GLuint unmap()
+    {
+        GLuint error;
+        if((error = bind()) != GL_NO_ERROR) {
+            return error;
         }
-        __GLW_HANDLE(mem = glMapBuffer(target_, GL_READ_ONLY)) {
-            return handle_error(__GLW_LAST_ERROR, "glMapBuffer");
+        __GLW_HANDLE(glUnmapBuffer(target_)) {
+            return handle_error(__GLW_LAST_ERROR, "glUnmapBuffer");
         }
-        memcpy(data__, (GLubyte*)mem + offset__, size__);
-        __GLW_HANDLE(glUnmapBuffer(target_)) {}
         return GL_NO_ERROR;
     }
 
+    // Replaces the data store with a new, uninitialized one. Pending draws
+    // keep reading the old store, so writing afterwards never stalls.
+    GLuint orphan()
+    {
+        GLuint error;
+        if((error = bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glBufferData(target_, size_, NULL, usage_)) {
+            return handle_error(__GLW_LAST_ERROR, "glBufferData");
+        }
+        return GL_NO_ERROR;
+    }
+
+    GLenum target() const { return target_; }
+    GLenum usage() const { return usage_; }
+    size_t size() const { return size_; }
+
     template <GLenum Name>
     GLint getInfo()
     {
+        GLuint error;
         GLint result;
-        __GLW_HANDLE(glBindBuffer(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindBuffer");
+        if((error = bind()) != GL_NO_ERROR) {
+            return error;
         }
         __GLW_HANDLE(glGetBufferParameteriv(target_, Name, &result)) {
             return handle_error(__GLW_LAST_ERROR, "glGetBufferParameteriv");
@@ -85,6 +184,121 @@ public:
     }
 };
 
+// Pending asynchronous read of a buffer range, see Buffer::readAsync().
+// The staging buffer is kept and reused by later reads of the same or a
+// smaller size.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicReadTicket
+{
+private:
+    static const GLuint debug_source = SOURCE_BUFFER;
+
+    BasicBuffer<ErrorPolicy>* staging_;
+    GLsync fence_;
+    size_t size_;
+
+    BasicReadTicket(const BasicReadTicket&);
+
+    void release()
+    {
+        if(fence_) glDeleteSync(fence_);
+        fence_ = 0;
+    }
+
+    GLuint clientWait(const GLuint64 timeout__, GLenum& status__)
+    {
+        __GLW_HANDLE(status__ = glClientWaitSync(fence_, GL_SYNC_FLUSH_COMMANDS_BIT, timeout__)) {
+            return handle_error(__GLW_LAST_ERROR, "glClientWaitSync");
+        }
+        if(status__ == GL_WAIT_FAILED) {
+            return handle_error(GL_INVALID_OPERATION, "glClientWaitSync");
+        }
+        if(status__ != GL_TIMEOUT_EXPIRED) {
+            release();
+        }
+        return GL_NO_ERROR;
+    }
+
+public:
+    BasicReadTicket()
+      : staging_(NULL),
+        fence_(0),
+        size_(0) {}
+
+    ~BasicReadTicket()
+    {
+        release();
+        delete staging_;
+    }
+
+    GLuint copy(const GLuint buffer__, const GLint offset__, const size_t size__)
+    {
+        StateCache& state = StateCache::current();
+        GLuint error = GL_NO_ERROR;
+
+        release();
+        if(!staging_ || staging_->size() < size__) {
+            delete staging_;
+            staging_ = new BasicBuffer<ErrorPolicy>(GL_COPY_WRITE_BUFFER, GL_STREAM_READ, size__, NULL, &error);
+            if(error != GL_NO_ERROR) {
+                return error;
+            }
+        }
+        if((error = state.bindBuffer<ErrorPolicy>(GL_COPY_READ_BUFFER, buffer__)) != GL_NO_ERROR) {
+            return error;
+        }
+        if((error = staging_->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset__, 0, size__)) {
+            return handle_error(__GLW_LAST_ERROR, "glCopyBufferSubData");
+        }
+        __GLW_HANDLE(fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)) {
+            return handle_error(__GLW_LAST_ERROR, "glFenceSync");
+        }
+        size_ = size__;
+        return GL_NO_ERROR;
+    }
+
+    // Polls without blocking.
+    bool ready()
+    {
+        GLenum status = GL_ALREADY_SIGNALED;
+        if(fence_ && clientWait(0, status) != GL_NO_ERROR) {
+            return false;
+        }
+        return status != GL_TIMEOUT_EXPIRED;
+    }
+
+    GLuint wait()
+    {
+        GLenum status = GL_TIMEOUT_EXPIRED;
+        GLuint error = GL_NO_ERROR;
+        while(fence_ && status == GL_TIMEOUT_EXPIRED && error == GL_NO_ERROR) {
+            error = clientWait(1000000, status);
+        }
+        return error;
+    }
+
+    // Waits for the copy if it is still pending and fetches its data.
+    GLuint read(void* data__)
+    {
+        GLuint error;
+        if(!staging_) {
+            return handle_error(GL_INVALID_OPERATION, "ReadTicket::read");
+        }
+        if((error = wait()) != GL_NO_ERROR) {
+            return error;
+        }
+        return staging_->read(0, size_, data__);
+    }
+
+    size_t size() const { return size_; }
+};
+
+typedef BasicBuffer<> Buffer;
+typedef BasicReadTicket<> ReadTicket;
+
 } // namespace
 
 #endif
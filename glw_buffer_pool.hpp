@@ -0,0 +1,435 @@
+
+#ifndef __GLW_BUFFER_POOL_HPP
+#define __GLW_BUFFER_POOL_HPP
+
+#include "glw_buffer.hpp"
+
+#include <algorithm>
+#include <set>
+
+namespace glw {
+
+// Packs many small ranges, e.g. the vertices and indices of thousands of
+// meshes, into a few large backing buffers so that they can be drawn with
+// one vertex array and without rebinding.
+//
+// Each backing buffer is split with a buddy allocator into power-of-two
+// blocks of at least min_block bytes; a freed block merges with its buddy
+// at once. Ranges are moved with glCopyBufferSubData by defragment(), which
+// empties sparsely used buffers into the others, and compact(), which
+// repacks everything into as few buffers as possible. Moves change the
+// buffer and offset of a range, so ranges are looked up through their
+// Allocation, and generation() changes whenever one has moved.
+//
+// Allocate vertices with the vertex stride as alignment and pass
+// offset / stride as the base vertex, and offset / index size as the first
+// index, of the indexed Program::execute().
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicBufferPool
+{
+public:
+    // Entries are reused once freed; generation tells copies of a freed
+    // allocation from the one now holding the entry.
+    struct Allocation
+    {
+        GLint index;
+        GLuint generation;
+        bool valid() const { return index >= 0; }
+    };
+
+    struct Range
+    {
+        GLuint buffer;
+        size_t offset;
+        size_t size;
+    };
+
+private:
+    static const GLuint debug_source = SOURCE_BUFFER;
+    static const size_t min_block = 256;
+
+    struct Page
+    {
+        BasicBuffer<ErrorPolicy>* buffer;
+        // Offsets of the free blocks of each order, of min_block << order
+        // bytes.
+        std::vector<std::set<size_t> > free;
+        size_t used;
+    };
+
+    struct Entry
+    {
+        Page* page;
+        size_t block;
+        GLint order;
+        size_t offset;
+        size_t size;
+        size_t alignment;
+        // Incremented each time the entry is freed.
+        GLuint generation;
+    };
+
+    std::vector<Page*> pages_;
+    std::vector<Entry> entries_;
+    std::vector<GLint> free_entries_;
+    GLenum target_;
+    GLenum usage_;
+    size_t page_size_;
+    size_t used_;
+    GLuint generation_;
+
+    BasicBufferPool(const BasicBufferPool&);
+
+    static GLint orderOf(const size_t size__)
+    {
+        GLint order = 0;
+        while((min_block << order) < size__) ++order;
+        return order;
+    }
+
+    // Bytes to reserve for size__ bytes at a multiple of alignment__.
+    // Blocks start at multiples of min_block, which covers power-of-two
+    // alignments up to it.
+    static size_t padded(const size_t size__, const size_t alignment__)
+    {
+        return min_block % alignment__ == 0 ? size__ : size__ + alignment__ - 1;
+    }
+
+    Page* createPage(const size_t size__, GLuint& error__)
+    {
+        Page* page = new Page();
+        page->buffer = new BasicBuffer<ErrorPolicy>(target_, usage_, size__, NULL, &error__);
+        page->free.resize(orderOf(size__) + 1);
+        page->free.back().insert(0);
+        page->used = 0;
+        if(error__ != GL_NO_ERROR) {
+            destroyPage(page);
+            return NULL;
+        }
+        pages_.push_back(page);
+        return page;
+    }
+
+    static void destroyPage(Page* page__)
+    {
+        delete page__->buffer;
+        delete page__;
+    }
+
+    // Takes a free block of the given order from page__, splitting a larger
+    // one if needed.
+    static bool take(Page* page__, const GLint order__, size_t& block__)
+    {
+        GLint order = order__;
+        while(order < (GLint)page__->free.size() && page__->free[order].empty()) ++order;
+        if(order >= (GLint)page__->free.size()) {
+            return false;
+        }
+        block__ = *page__->free[order].begin();
+        page__->free[order].erase(page__->free[order].begin());
+        while(order > order__) {
+            --order;
+            page__->free[order].insert(block__ + (min_block << order));
+        }
+        page__->used += min_block << order__;
+        return true;
+    }
+
+    // Returns a block, merging it with its free buddy as long as there is
+    // one.
+    static void give(Page* page__, size_t block__, GLint order__)
+    {
+        page__->used -= min_block << order__;
+        while(order__ + 1 < (GLint)page__->free.size()) {
+            const size_t buddy = block__ ^ (min_block << order__);
+            std::set<size_t>::iterator found = page__->free[order__].find(buddy);
+            if(found == page__->free[order__].end()) break;
+            page__->free[order__].erase(found);
+            block__ = std::min(block__, buddy);
+            ++order__;
+        }
+        page__->free[order__].insert(block__);
+    }
+
+    // Finds room for entry__ in the pages from first__ on, other than
+    // skip__, and creates a page if grow__ is set and none has any.
+    bool place(
+        Entry& entry__,
+        const size_t first__,
+        const Page* skip__,
+        const bool grow__,
+        GLuint& error__)
+    {
+        const GLint order = orderOf(padded(entry__.size, entry__.alignment));
+        for(size_t i = first__; i < pages_.size(); ++i) {
+            if(pages_[i] != skip__ && take(pages_[i], order, entry__.block)) {
+                entry__.page = pages_[i];
+                entry__.order = order;
+                entry__.offset = (entry__.block + entry__.alignment - 1) / entry__.alignment * entry__.alignment;
+                return true;
+            }
+        }
+        if(!grow__) {
+            return false;
+        }
+        Page* page = createPage(std::max(page_size_, min_block << order), error__);
+        if(!page || !take(page, order, entry__.block)) {
+            return false;
+        }
+        entry__.page = page;
+        entry__.order = order;
+        entry__.offset = (entry__.block + entry__.alignment - 1) / entry__.alignment * entry__.alignment;
+        return true;
+    }
+
+    GLuint copy(const Entry& from__, const Entry& to__)
+    {
+        GLuint error;
+        StateCache& state = StateCache::current();
+        if((error = state.bindBuffer<ErrorPolicy>(GL_COPY_READ_BUFFER, from__.page->buffer->id())) != GL_NO_ERROR) {
+            return error;
+        }
+        if((error = state.bindBuffer<ErrorPolicy>(GL_COPY_WRITE_BUFFER, to__.page->buffer->id())) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glCopyBufferSubData(
+            GL_COPY_READ_BUFFER,
+            GL_COPY_WRITE_BUFFER,
+            from__.offset,
+            to__.offset,
+            from__.size)) {
+            return handle_error(__GLW_LAST_ERROR, "glCopyBufferSubData");
+        }
+        return GL_NO_ERROR;
+    }
+
+    bool live(const Allocation allocation__) const
+    {
+        return allocation__.valid() &&
+            allocation__.index < (GLint)entries_.size() &&
+            entries_[allocation__.index].page &&
+            entries_[allocation__.index].generation == allocation__.generation;
+    }
+
+    struct LargerFirst
+    {
+        const std::vector<Entry>* entries;
+
+        bool operator()(const GLint a, const GLint b) const
+        {
+            return (*entries)[a].order > (*entries)[b].order;
+        }
+    };
+
+    struct LessUsedFirst
+    {
+        bool operator()(const Page* a, const Page* b) const
+        {
+            return a->used < b->used;
+        }
+    };
+
+public:
+    // Backing buffers are page_size__ bytes, rounded up to a power of two,
+    // or larger for larger allocations.
+    BasicBufferPool(
+        const GLenum target__ = GL_ARRAY_BUFFER,
+        const GLenum usage__ = GL_STATIC_DRAW,
+        const size_t page_size__ = 16 * 1024 * 1024)
+      : target_(target__),
+        usage_(usage__),
+        page_size_(min_block << orderOf(page_size__)),
+        used_(0),
+        generation_(0) {}
+
+    ~BasicBufferPool()
+    {
+        for(size_t i = 0; i < pages_.size(); ++i) {
+            destroyPage(pages_[i]);
+        }
+    }
+
+    // Reserves size__ bytes at an offset that is a multiple of
+    // alignment__. Returns an invalid allocation if no backing buffer could
+    // be created.
+    Allocation allocate(const size_t size__, const size_t alignment__ = 16, GLuint* error__ = NULL)
+    {
+        Allocation result = { -1, 0 };
+        GLuint status = GL_NO_ERROR;
+        Entry entry = { NULL, 0, 0, 0, size__, std::max<size_t>(1, alignment__), 0 };
+        if(!size__) {
+            status = handle_error(GL_INVALID_VALUE, "BufferPool::allocate");
+        } else if(place(entry, 0, NULL, true, status)) {
+            if(free_entries_.empty()) {
+                result.index = entries_.size();
+                entries_.push_back(entry);
+            } else {
+                result.index = free_entries_.back();
+                free_entries_.pop_back();
+                entry.generation = entries_[result.index].generation;
+                entries_[result.index] = entry;
+            }
+            used_ += size__;
+        } else if(status == GL_NO_ERROR) {
+            status = handle_error(GL_OUT_OF_MEMORY, "BufferPool::allocate");
+        }
+        result.generation = entry.generation;
+        if(error__) *error__ = status;
+        return result;
+    }
+
+    // Returns the range to its backing buffer. Buffers left empty are kept
+    // until the next defragment() or compact().
+    GLuint free(Allocation& allocation__)
+    {
+        if(!live(allocation__)) {
+            return handle_error(GL_INVALID_VALUE, "BufferPool::free");
+        }
+        Entry& entry = entries_[allocation__.index];
+        give(entry.page, entry.block, entry.order);
+        used_ -= entry.size;
+        entry.page = NULL;
+        ++entry.generation;
+        free_entries_.push_back(allocation__.index);
+        allocation__.index = -1;
+        return GL_NO_ERROR;
+    }
+
+    // Current buffer and offset of an allocation; a buffer of 0 if it is
+    // not one of this pool.
+    Range range(const Allocation allocation__) const
+    {
+        Range result = { 0, 0, 0 };
+        if(live(allocation__)) {
+            const Entry& entry = entries_[allocation__.index];
+            result.buffer = entry.page->buffer->id();
+            result.offset = entry.offset;
+            result.size = entry.size;
+        }
+        return result;
+    }
+
+    // Writes size__ bytes at offset__ within the range.
+    GLuint write(
+        const Allocation allocation__,
+        const size_t offset__,
+        const size_t size__,
+        const void* data__)
+    {
+        if(!live(allocation__) || offset__ + size__ > entries_[allocation__.index].size) {
+            return handle_error(GL_INVALID_VALUE, "BufferPool::write");
+        }
+        const Entry& entry = entries_[allocation__.index];
+        return entry.page->buffer->write(entry.offset + offset__, size__, data__);
+    }
+
+    GLuint read(
+        const Allocation allocation__,
+        const size_t offset__,
+        const size_t size__,
+        void* data__)
+    {
+        if(!live(allocation__) || offset__ + size__ > entries_[allocation__.index].size) {
+            return handle_error(GL_INVALID_VALUE, "BufferPool::read");
+        }
+        const Entry& entry = entries_[allocation__.index];
+        return entry.page->buffer->read(entry.offset + offset__, size__, data__);
+    }
+
+    // Moves the ranges of the least used backing buffers into free blocks
+    // of the others and deletes the buffers that end up empty. Needs no
+    // memory beyond the pool's own.
+    GLuint defragment()
+    {
+        __GLW_PROFILE("BufferPool::defragment");
+        std::sort(pages_.begin(), pages_.end(), LessUsedFirst());
+        GLuint error = GL_NO_ERROR;
+        bool moved = false;
+        for(size_t i = 0; i < pages_.size() && error == GL_NO_ERROR; ++i) {
+            Page* page = pages_[i];
+            for(size_t j = 0; j < entries_.size() && error == GL_NO_ERROR; ++j) {
+                if(entries_[j].page != page) continue;
+                Entry target = entries_[j];
+                if(!place(target, i + 1, page, false, error)) break;
+                if((error = copy(entries_[j], target)) != GL_NO_ERROR) {
+                    give(target.page, target.block, target.order);
+                    break;
+                }
+                give(page, entries_[j].block, entries_[j].order);
+                entries_[j] = target;
+                moved = true;
+            }
+        }
+        for(size_t i = 0; i < pages_.size();) {
+            if(pages_[i]->used == 0) {
+                destroyPage(pages_[i]);
+                pages_.erase(pages_.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+        if(moved) ++generation_;
+        return error;
+    }
+
+    // Repacks every range, largest first, into new backing buffers, which
+    // leaves no free block but at the end of the last one. Both the old
+    // and the new buffers are held until the copies have been issued.
+    GLuint compact()
+    {
+        __GLW_PROFILE("BufferPool::compact");
+        std::vector<GLint> order;
+        for(size_t i = 0; i < entries_.size(); ++i) {
+            if(entries_[i].page) order.push_back(i);
+        }
+        LargerFirst larger_first = { &entries_ };
+        std::stable_sort(order.begin(), order.end(), larger_first);
+
+        std::vector<Page*> old;
+        old.swap(pages_);
+        std::vector<Entry> moved(entries_);
+        GLuint error = GL_NO_ERROR;
+        for(size_t i = 0; i < order.size() && error == GL_NO_ERROR; ++i) {
+            Entry& target = moved[order[i]];
+            if(!place(target, 0, NULL, true, error)) {
+                if(error == GL_NO_ERROR) error = handle_error(GL_OUT_OF_MEMORY, "BufferPool::compact");
+                break;
+            }
+            error = copy(entries_[order[i]], target);
+        }
+
+        // Keep the old buffers if any range could not be moved.
+        std::vector<Page*>& unused = error == GL_NO_ERROR ? old : pages_;
+        for(size_t i = 0; i < unused.size(); ++i) {
+            destroyPage(unused[i]);
+        }
+        if(error != GL_NO_ERROR) {
+            pages_.swap(old);
+            return error;
+        }
+        entries_.swap(moved);
+        ++generation_;
+        return GL_NO_ERROR;
+    }
+
+    // Bytes of the backing buffers, and bytes allocated from them.
+    size_t capacity() const
+    {
+        size_t result = 0;
+        for(size_t i = 0; i < pages_.size(); ++i) {
+            result += pages_[i]->buffer->size();
+        }
+        return result;
+    }
+
+    size_t used() const { return used_; }
+    size_t pages() const { return pages_.size(); }
+    BasicBuffer<ErrorPolicy>& page(const size_t index__) { return *pages_[index__]->buffer; }
+    GLuint generation() const { return generation_; }
+};
+
+typedef BasicBufferPool<> BufferPool;
+
+} // namespace
+
+#endif
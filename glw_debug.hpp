@@ -0,0 +1,222 @@
+
+#ifndef __GLW_DEBUG_HPP
+#define __GLW_DEBUG_HPP
+
+#include "glw.hpp"
+
+#include <atomic>
+
+namespace glw {
+
+struct DebugMessage
+{
+    static const size_t text_size = 256;
+    GLenum source;
+    GLenum type;
+    GLuint id;
+    GLenum severity;
+    GLuint wrapper;
+    char text[text_size];
+};
+
+// Bounded multi-producer, single-consumer message queue. Producers never
+// block; messages pushed while the queue is full are dropped and counted.
+template <size_t Capacity>
+class DebugQueue
+{
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        DebugMessage message;
+    };
+
+    Slot slots_[Capacity];
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+    std::atomic<size_t> dropped_;
+
+    DebugQueue(const DebugQueue&);
+
+public:
+    DebugQueue()
+      : head_(0),
+        tail_(0),
+        dropped_(0)
+    {
+        for(size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const DebugMessage& message__)
+    {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for(;;) {
+            slot = &slots_[position % Capacity];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if(sequence == position) {
+                if(tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(sequence < position) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->message = message__;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(DebugMessage& message__)
+    {
+        const size_t position = head_.load(std::memory_order_relaxed);
+        Slot* slot = &slots_[position % Capacity];
+        if(slot->sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        message__ = slot->message;
+        slot->sequence.store(position + Capacity, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+};
+
+// Receives KHR_debug messages for the current context. Errors and other
+// messages are queued for poll(), driver performance warnings (stalls,
+// recompiles, slow paths) for pollPerformance(). Messages are attributed
+// to the issuing wrapper when __GLW_ENABLE_DEBUG_OUTPUT is defined and the
+// driver calls back on the issuing thread, which synchronous__ enforces.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicDebugOutput
+{
+public:
+    static const size_t queue_size = 1024;
+    typedef DebugQueue<queue_size> Queue;
+
+    enum Severity
+    {
+        SEVERITY_HIGH,
+        SEVERITY_MEDIUM,
+        SEVERITY_LOW,
+        SEVERITY_NOTIFICATION,
+        SEVERITY_COUNT
+    };
+
+private:
+    static const GLuint debug_source = SOURCE_UNKNOWN;
+
+    Queue messages_;
+    Queue performance_;
+    std::atomic<size_t> counts_[SEVERITY_COUNT][SOURCE_COUNT];
+
+    BasicDebugOutput(const BasicDebugOutput&);
+
+    static GLuint severityIndex(const GLenum severity__)
+    {
+        switch(severity__) {
+        case GL_DEBUG_SEVERITY_HIGH:    return SEVERITY_HIGH;
+        case GL_DEBUG_SEVERITY_MEDIUM:  return SEVERITY_MEDIUM;
+        case GL_DEBUG_SEVERITY_LOW:     return SEVERITY_LOW;
+        default:                        return SEVERITY_NOTIFICATION;
+        }
+    }
+
+    static void APIENTRY callback(
+        GLenum source__,
+        GLenum type__,
+        GLuint id__,
+        GLenum severity__,
+        GLsizei length__,
+        const GLchar* text__,
+        const void* user__)
+    {
+        BasicDebugOutput* self = (BasicDebugOutput*)user__;
+        DebugMessage message;
+        message.source = source__;
+        message.type = type__;
+        message.id = id__;
+        message.severity = severity__;
+        message.wrapper = current_source();
+
+        size_t length = length__ < 0 ? strlen(text__) : length__;
+        if(length >= DebugMessage::text_size) {
+            length = DebugMessage::text_size - 1;
+        }
+        memcpy(message.text, text__, length);
+        message.text[length] = '\0';
+
+        self->counts_[severityIndex(severity__)][message.wrapper].fetch_add(1, std::memory_order_relaxed);
+        if(type__ == GL_DEBUG_TYPE_PERFORMANCE) {
+            self->performance_.push(message);
+        } else {
+            self->messages_.push(message);
+        }
+    }
+
+public:
+    BasicDebugOutput(const bool synchronous__ = false, GLuint* error = NULL)
+    {
+        for(int i = 0; i < SEVERITY_COUNT; ++i) {
+            for(int j = 0; j < SOURCE_COUNT; ++j) {
+                counts_[i][j].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        __GLW_HANDLE(glDebugMessageCallback(callback, this)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glDebugMessageCallback");
+            return;
+        }
+        __GLW_HANDLE(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glDebugMessageControl");
+            return;
+        }
+        __GLW_HANDLE(glEnable(GL_DEBUG_OUTPUT)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glEnable");
+            return;
+        }
+        if(synchronous__) {
+            __GLW_HANDLE(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS)) {
+                if(error) *error = handle_error(__GLW_LAST_ERROR, "glEnable");
+            }
+        }
+    }
+
+    ~BasicDebugOutput()
+    {
+        glDisable(GL_DEBUG_OUTPUT);
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(NULL, NULL);
+    }
+
+    bool poll(DebugMessage& message__) { return messages_.pop(message__); }
+    bool pollPerformance(DebugMessage& message__) { return performance_.pop(message__); }
+
+    size_t count(const GLenum severity__, const GLuint wrapper__) const
+    {
+        return counts_[severityIndex(severity__)][wrapper__].load(std::memory_order_relaxed);
+    }
+
+    size_t count(const GLenum severity__) const
+    {
+        size_t result = 0;
+        for(int i = 0; i < SOURCE_COUNT; ++i) {
+            result += count(severity__, i);
+        }
+        return result;
+    }
+
+    size_t dropped() const { return messages_.dropped() + performance_.dropped(); }
+};
+
+typedef BasicDebugOutput<> DebugOutput;
+
+} // namespace
+
+#endif
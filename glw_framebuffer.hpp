@@ -0,0 +1,320 @@
+
+#ifndef __GLW_FRAMEBUFFER_HPP
+#define __GLW_FRAMEBUFFER_HPP
+
+#include "glw_texture.hpp"
+
+namespace glw {
+
+// Render target that is never sampled, e.g. depth or multisampled color
+// resolved into a texture. samples__ of 0 gives a single sampled buffer.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicRenderbuffer : public Wrapper
+{
+private:
+    static const GLuint debug_source = SOURCE_FRAMEBUFFER;
+
+    GLenum format_;
+    GLint size_x_;
+    GLint size_y_;
+    GLint samples_;
+
+public:
+    BasicRenderbuffer(
+        const GLenum internal_format__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint samples__ = 0,
+        GLuint* error = NULL)
+      : format_(internal_format__),
+        size_x_(size_x__),
+        size_y_(size_y__),
+        samples_(samples__)
+    {
+        __GLW_HANDLE(glGenRenderbuffers(1, &handle_)) {}
+        __GLW_HANDLE(glBindRenderbuffer(GL_RENDERBUFFER, handle_)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glBindRenderbuffer");
+            return;
+        }
+        __GLW_HANDLE(glRenderbufferStorageMultisample(
+            GL_RENDERBUFFER,
+            samples_,
+            format_,
+            size_x_,
+            size_y_)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glRenderbufferStorageMultisample");
+        }
+    }
+
+    ~BasicRenderbuffer()
+    {
+        if(handle_) {
+            glDeleteRenderbuffers(1, &handle_);
+        }
+    }
+
+    GLenum format() const { return format_; }
+    GLint width() const { return size_x_; }
+    GLint height() const { return size_y_; }
+    GLint samples() const { return samples_; }
+};
+
+// Offscreen render target made of texture and renderbuffer attachments,
+// for rendering without a window. Attachments are edited through the draw
+// framebuffer binding, which is restored afterwards, and color attachments
+// are drawn to in the order they were attached.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicFramebuffer : public Wrapper
+{
+private:
+    static const GLuint debug_source = SOURCE_FRAMEBUFFER;
+
+    std::vector<GLenum> draw_buffers_;
+    GLint size_x_;
+    GLint size_y_;
+    GLint samples_;
+    GLint previous_;
+
+    BasicFramebuffer(const BasicFramebuffer&);
+
+    GLuint beginEdit()
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_);
+        __GLW_HANDLE(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, handle_)) {
+            return handle_error(__GLW_LAST_ERROR, "glBindFramebuffer");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Records the new attachment and restores the previous binding.
+    GLuint endEdit(
+        GLuint error__,
+        const GLenum attachment__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint samples__)
+    {
+        if(error__ == GL_NO_ERROR) {
+            // The framebuffer is as large as its smallest attachment.
+            size_x_ = size_x_ ? std::min(size_x_, size_x__) : size_x__;
+            size_y_ = size_y_ ? std::min(size_y_, size_y__) : size_y__;
+            samples_ = std::max(samples_, samples__);
+
+            const bool color = attachment__ >= GL_COLOR_ATTACHMENT0 && attachment__ <= GL_COLOR_ATTACHMENT15;
+            if(color && std::find(draw_buffers_.begin(), draw_buffers_.end(), attachment__) == draw_buffers_.end()) {
+                draw_buffers_.push_back(attachment__);
+                __GLW_HANDLE(glDrawBuffers(draw_buffers_.size(), &draw_buffers_[0])) {
+                    error__ = handle_error(__GLW_LAST_ERROR, "glDrawBuffers");
+                }
+            }
+        }
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_);
+        return error__;
+    }
+
+public:
+    BasicFramebuffer(GLuint* error = NULL)
+      : size_x_(0),
+        size_y_(0),
+        samples_(0),
+        previous_(0)
+    {
+        __GLW_HANDLE(glGenFramebuffers(1, &handle_)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glGenFramebuffers");
+        }
+    }
+
+    ~BasicFramebuffer()
+    {
+        if(handle_) {
+            glDeleteFramebuffers(1, &handle_);
+        }
+    }
+
+    // Attaches a level of a 2D texture, e.g. to GL_COLOR_ATTACHMENT0 or
+    // GL_DEPTH_ATTACHMENT.
+    GLuint attach(
+        const GLenum attachment__,
+        BasicTexture2D<ErrorPolicy>& texture__,
+        const GLint lod__ = 0)
+    {
+        GLuint error;
+        if((error = beginEdit()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment__, GL_TEXTURE_2D, texture__.id(), lod__)) {
+            error = handle_error(__GLW_LAST_ERROR, "glFramebufferTexture2D");
+        }
+        return endEdit(
+            error,
+            attachment__,
+            std::max(1, texture__.width() >> lod__),
+            std::max(1, texture__.height() >> lod__),
+            0);
+    }
+
+    // Attaches one image of a texture: the layer of an array or 3D texture,
+    // or the face of a cube map.
+    GLuint attach(
+        const GLenum attachment__,
+        BasicTexture<ErrorPolicy>& texture__,
+        const GLint lod__,
+        const GLint layer__)
+    {
+        GLuint error;
+        if((error = beginEdit()) != GL_NO_ERROR) {
+            return error;
+        }
+        if(texture__.target() == GL_TEXTURE_CUBE_MAP) {
+            __GLW_HANDLE(glFramebufferTexture2D(
+                GL_DRAW_FRAMEBUFFER,
+                attachment__,
+                GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer__,
+                texture__.id(),
+                lod__)) {
+                error = handle_error(__GLW_LAST_ERROR, "glFramebufferTexture2D");
+            }
+        } else {
+            __GLW_HANDLE(glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, attachment__, texture__.id(), lod__, layer__)) {
+                error = handle_error(__GLW_LAST_ERROR, "glFramebufferTextureLayer");
+            }
+        }
+        return endEdit(
+            error,
+            attachment__,
+            std::max(1, texture__.width() >> lod__),
+            std::max(1, texture__.height() >> lod__),
+            0);
+    }
+
+    GLuint attach(const GLenum attachment__, BasicRenderbuffer<ErrorPolicy>& renderbuffer__)
+    {
+        GLuint error;
+        if((error = beginEdit()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, attachment__, GL_RENDERBUFFER, renderbuffer__.id())) {
+            error = handle_error(__GLW_LAST_ERROR, "glFramebufferRenderbuffer");
+        }
+        return endEdit(
+            error,
+            attachment__,
+            renderbuffer__.width(),
+            renderbuffer__.height(),
+            renderbuffer__.samples());
+    }
+
+    // GL_FRAMEBUFFER_COMPLETE once the attachments can be rendered to.
+    GLenum status()
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, handle_);
+        const GLenum result = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+        return result;
+    }
+
+    // Binds for drawing and reading, and sets the viewport to cover the
+    // framebuffer.
+    GLuint bind()
+    {
+        __GLW_HANDLE(glBindFramebuffer(GL_FRAMEBUFFER, handle_)) {
+            return handle_error(__GLW_LAST_ERROR, "glBindFramebuffer");
+        }
+        __GLW_HANDLE(glViewport(0, 0, size_x_, size_y_)) {
+            return handle_error(__GLW_LAST_ERROR, "glViewport");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Copies a region into target__, 0 for the default framebuffer. Regions
+    // of different sizes are scaled with filter__; multisampled
+    // framebuffers are resolved, which needs regions of the same size.
+    GLuint blit(
+        const GLuint target__,
+        const GLint source_x0__,
+        const GLint source_y0__,
+        const GLint source_x1__,
+        const GLint source_y1__,
+        const GLint target_x0__,
+        const GLint target_y0__,
+        const GLint target_x1__,
+        const GLint target_y1__,
+        const GLbitfield mask__ = GL_COLOR_BUFFER_BIT,
+        const GLenum filter__ = GL_NEAREST)
+    {
+        __GLW_PROFILE("Framebuffer::blit");
+        GLint previous_read = 0;
+        GLint previous_draw = 0;
+        GLuint error = GL_NO_ERROR;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw);
+        __GLW_HANDLE(glBindFramebuffer(GL_READ_FRAMEBUFFER, handle_)) {
+            error = handle_error(__GLW_LAST_ERROR, "glBindFramebuffer");
+        }
+        if(error == GL_NO_ERROR) {
+            __GLW_HANDLE(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target__)) {
+                error = handle_error(__GLW_LAST_ERROR, "glBindFramebuffer");
+            }
+        }
+        if(error == GL_NO_ERROR) {
+            __GLW_HANDLE(glBlitFramebuffer(
+                source_x0__, source_y0__, source_x1__, source_y1__,
+                target_x0__, target_y0__, target_x1__, target_y1__,
+                mask__,
+                filter__)) {
+                error = handle_error(__GLW_LAST_ERROR, "glBlitFramebuffer");
+            }
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previous_read);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_draw);
+        return error;
+    }
+
+    // Resolves a multisampled framebuffer into a single sampled one of the
+    // same size, or copies it.
+    GLuint resolve(BasicFramebuffer& target__, const GLbitfield mask__ = GL_COLOR_BUFFER_BIT)
+    {
+        return blit(target__.id(), 0, 0, size_x_, size_y_, 0, 0, size_x_, size_y_, mask__);
+    }
+
+    // Tells the driver the contents of attachments__ are no longer needed,
+    // e.g. depth and multisampled color after a resolve, so tiled and
+    // bandwidth-limited GPUs can skip writing them back to memory. Does
+    // nothing without GL 4.3 or ARB_invalidate_subdata.
+    GLuint invalidate(const GLenum* attachments__, const GLsizei count__)
+    {
+        if(!StateCache::current().supports(StateCache::CAPABILITY_INVALIDATE_SUBDATA)) {
+            return GL_NO_ERROR;
+        }
+        GLint previous = 0;
+        GLuint error = GL_NO_ERROR;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+        __GLW_HANDLE(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, handle_)) {
+            return handle_error(__GLW_LAST_ERROR, "glBindFramebuffer");
+        }
+        __GLW_HANDLE(glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, count__, attachments__)) {
+            error = handle_error(__GLW_LAST_ERROR, "glInvalidateFramebuffer");
+        }
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+        return error;
+    }
+
+    GLuint invalidate(const GLenum attachment__)
+    {
+        return invalidate(&attachment__, 1);
+    }
+
+    GLint width() const { return size_x_; }
+    GLint height() const { return size_y_; }
+    GLint samples() const { return samples_; }
+    const std::vector<GLenum>& drawBuffers() const { return draw_buffers_; }
+};
+
+typedef BasicRenderbuffer<> Renderbuffer;
+typedef BasicFramebuffer<> Framebuffer;
+
+} // namespace
+
+#endif
@@ -0,0 +1,268 @@
+
+#ifndef __GLW_MIPMAP_HPP
+#define __GLW_MIPMAP_HPP
+
+#include "glw_texture.hpp"
+
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define __GLW_MIPMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace glw {
+
+// CPU mip generation for 8-bit images with tightly packed rows, for
+// offline processing and streaming where the driver's glGenerateMipmap is
+// not available or not wanted. The box filter averages 2x2 blocks; the
+// Kaiser-windowed sinc filter keeps more detail at the cost of some
+// ringing. Work is split by rows over threads__ threads, or one per core
+// if 0.
+enum MipFilter
+{
+    MIP_FILTER_BOX,
+    MIP_FILTER_KAISER
+};
+
+class MipGenerator
+{
+private:
+    // Taps of the Kaiser filter around each output sample, in input pixels.
+    static const GLint kaiser_taps = 8;
+
+    struct Image
+    {
+        const GLubyte* in;
+        GLubyte* out;
+        GLfloat* temporary;
+        GLint size_x;
+        GLint size_y;
+        GLint channels;
+    };
+
+    static GLint clamp(const GLint value__, const GLint high__)
+    {
+        return value__ < 0 ? 0 : (value__ > high__ ? high__ : value__);
+    }
+
+    static void boxRows(const Image& image__, const GLint begin__, const GLint end__)
+    {
+        const GLint out_x = std::max(1, image__.size_x / 2);
+        const GLint channels = image__.channels;
+        const size_t line = image__.size_x * channels;
+
+        for(GLint y = begin__; y < end__; ++y) {
+            const GLubyte* row0 = image__.in + clamp(y * 2, image__.size_y - 1) * line;
+            const GLubyte* row1 = image__.in + clamp(y * 2 + 1, image__.size_y - 1) * line;
+            GLubyte* out = image__.out + (size_t)y * out_x * channels;
+            GLint x = 0;
+#ifdef __GLW_MIPMAP_SSE2
+            // Two RGBA output pixels from four input pixels of each row.
+            if(channels == 4 && row0 != row1) {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i round = _mm_set1_epi16(2);
+                for(; x * 2 + 3 < image__.size_x; x += 2) {
+                    const __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                    const __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+                    const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                    const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                    __m128i sum = _mm_unpacklo_epi64(
+                        _mm_add_epi16(low, _mm_srli_si128(low, 8)),
+                        _mm_add_epi16(high, _mm_srli_si128(high, 8)));
+                    sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                    _mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, sum));
+                }
+            }
+#endif
+            for(; x < out_x; ++x) {
+                const GLint x0 = clamp(x * 2, image__.size_x - 1) * channels;
+                const GLint x1 = clamp(x * 2 + 1, image__.size_x - 1) * channels;
+                for(GLint c = 0; c < channels; ++c) {
+                    out[x * channels + c] = (GLubyte)((
+                        row0[x0 + c] + row0[x1 + c] +
+                        row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    static GLfloat bessel0(const GLfloat x__)
+    {
+        GLfloat sum = 1.0f;
+        GLfloat term = 1.0f;
+        for(GLint k = 1; k < 16; ++k) {
+            term *= (x__ / (2.0f * k)) * (x__ / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Weights of the input pixels 2x - 3 .. 2x + 4 for output pixel x.
+    struct KaiserWeights
+    {
+        GLfloat weights[kaiser_taps];
+
+        KaiserWeights()
+        {
+            const GLfloat alpha = 4.0f;
+            const GLfloat pi = 3.14159265358979f;
+            const GLfloat width = kaiser_taps / 2.0f;
+            GLfloat sum = 0.0f;
+            for(GLint i = 0; i < kaiser_taps; ++i) {
+                // Distance from the output center, in input pixels.
+                const GLfloat d = i - (kaiser_taps / 2 - 1) - 0.5f;
+                const GLfloat t = d / width;
+                const GLfloat sinc = std::sin(pi * d / 2.0f) / (pi * d / 2.0f);
+                const GLfloat window = bessel0(alpha * std::sqrt(std::max(0.0f, 1.0f - t * t))) / bessel0(alpha);
+                weights[i] = sinc * window;
+                sum += weights[i];
+            }
+            for(GLint i = 0; i < kaiser_taps; ++i) {
+                weights[i] /= sum;
+            }
+        }
+    };
+
+    static const GLfloat* kaiserWeights()
+    {
+        static const KaiserWeights result;
+        return result.weights;
+    }
+
+    // Filters input rows horizontally into the temporary image.
+    static void kaiserColumns(const Image& image__, const GLint begin__, const GLint end__)
+    {
+        const GLfloat* weights = kaiserWeights();
+        const GLint out_x = std::max(1, image__.size_x / 2);
+        const GLint channels = image__.channels;
+
+        for(GLint y = begin__; y < end__; ++y) {
+            const GLubyte* row = image__.in + (size_t)y * image__.size_x * channels;
+            GLfloat* out = image__.temporary + (size_t)y * out_x * channels;
+            for(GLint x = 0; x < out_x; ++x) {
+                for(GLint c = 0; c < channels; ++c) {
+                    GLfloat sum = 0.0f;
+                    for(GLint i = 0; i < kaiser_taps; ++i) {
+                        const GLint source = clamp(x * 2 - (kaiser_taps / 2 - 1) + i, image__.size_x - 1);
+                        sum += weights[i] * row[source * channels + c];
+                    }
+                    out[x * channels + c] = sum;
+                }
+            }
+        }
+    }
+
+    // Filters the temporary image vertically into the output rows.
+    static void kaiserRows(const Image& image__, const GLint begin__, const GLint end__)
+    {
+        const GLfloat* weights = kaiserWeights();
+        const size_t line = std::max(1, image__.size_x / 2) * image__.channels;
+
+        for(GLint y = begin__; y < end__; ++y) {
+            GLubyte* out = image__.out + y * line;
+            for(size_t i = 0; i < line; ++i) {
+                GLfloat sum = 0.0f;
+                for(GLint j = 0; j < kaiser_taps; ++j) {
+                    const GLint source = clamp(y * 2 - (kaiser_taps / 2 - 1) + j, image__.size_y - 1);
+                    sum += weights[j] * image__.temporary[source * line + i];
+                }
+                out[i] = (GLubyte)clamp((GLint)(sum + 0.5f), 255);
+            }
+        }
+    }
+
+    static void parallel(
+        void (*function__)(const Image&, GLint, GLint),
+        const Image& image__,
+        const GLint rows__,
+        unsigned threads__)
+    {
+        // Small levels are not worth a thread.
+        const size_t work = (size_t)rows__ * image__.size_x * image__.channels;
+        if(threads__ == 0) threads__ = std::max(1u, std::thread::hardware_concurrency());
+        if(work < 64 * 1024) threads__ = 1;
+        if(threads__ > (unsigned)rows__) threads__ = rows__;
+
+        std::vector<std::thread> workers;
+        const GLint step = (rows__ + threads__ - 1) / threads__;
+        for(unsigned i = 1; i < threads__; ++i) {
+            const GLint begin = i * step;
+            if(begin >= rows__) break;
+            workers.push_back(std::thread(function__, image__, begin, std::min(rows__, begin + step)));
+        }
+        function__(image__, 0, std::min(rows__, step));
+        for(size_t i = 0; i < workers.size(); ++i) {
+            workers[i].join();
+        }
+    }
+
+public:
+    // Writes the next level of in__, max(1, size / 2) in each dimension,
+    // to out__.
+    static void downsample(
+        const GLubyte* in__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint channels__,
+        GLubyte* out__,
+        const MipFilter filter__ = MIP_FILTER_BOX,
+        const unsigned threads__ = 0)
+    {
+        Image image = { in__, out__, NULL, size_x__, size_y__, channels__ };
+        const GLint out_y = std::max(1, size_y__ / 2);
+        if(filter__ == MIP_FILTER_BOX) {
+            parallel(boxRows, image, out_y, threads__);
+            return;
+        }
+        std::vector<GLfloat> temporary((size_t)std::max(1, size_x__ / 2) * size_y__ * channels__);
+        image.temporary = &temporary[0];
+        parallel(kaiserColumns, image, size_y__, threads__);
+        parallel(kaiserRows, image, out_y, threads__);
+    }
+};
+
+// Computes levels 1 and up of texture__ from level0__, an image of its
+// size in format__, and uploads them. Only 8-bit formats are supported.
+template <class ErrorPolicy>
+GLuint write_mipmaps(
+    BasicTexture2D<ErrorPolicy>& texture__,
+    const ImageFormat& format__,
+    const GLubyte* level0__,
+    const MipFilter filter__ = MIP_FILTER_BOX,
+    const unsigned threads__ = 0)
+{
+    if(format__.type != GL_UNSIGNED_BYTE) {
+        return handle_error(GL_INVALID_ENUM, "write_mipmaps");
+    }
+    const GLint channels = sizeof_pixel(format__);
+    GLint size_x = texture__.width();
+    GLint size_y = texture__.height();
+    std::vector<GLubyte> levels[2];
+    const GLubyte* in = level0__;
+
+    GLint alignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    GLuint error = GL_NO_ERROR;
+    for(GLint level = 1; level < texture__.levels() && error == GL_NO_ERROR; ++level) {
+        std::vector<GLubyte>& out = levels[level % 2];
+        const GLint next_x = std::max(1, size_x / 2);
+        const GLint next_y = std::max(1, size_y / 2);
+        out.resize((size_t)next_x * next_y * channels);
+        MipGenerator::downsample(in, size_x, size_y, channels, &out[0], filter__, threads__);
+        error = texture__.write(level, format__, 0, 0, next_x, next_y, &out[0]);
+        in = &out[0];
+        size_x = next_x;
+        size_y = next_y;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    return error;
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,235 @@
+
+#ifndef __GLW_PIXEL_TRANSFER_HPP
+#define __GLW_PIXEL_TRANSFER_HPP
+
+#include "glw_buffer.hpp"
+#include "glw_texture.hpp"
+
+namespace glw {
+
+// Asynchronous texture uploads and readbacks through rings of pixel
+// buffer objects. Each transfer uses the next buffer of its ring and is
+// fenced; the CPU only waits when a ring wraps around onto a transfer the
+// GPU has not finished. With three buffers, reading back frame N and
+// fetching it at frame N + 2 never blocks.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicPixelTransfer
+{
+private:
+    struct Slot
+    {
+        BasicBuffer<ErrorPolicy>* buffer;
+        GLsync fence;
+        size_t size;
+    };
+
+    typedef std::vector<Slot> Slots;
+
+    static const GLuint debug_source = SOURCE_TEXTURE;
+
+    Slots pack_;
+    Slots unpack_;
+    size_t next_pack_;
+    size_t next_unpack_;
+
+    BasicPixelTransfer(const BasicPixelTransfer&);
+
+    GLuint clientWait(Slot& slot__, const GLuint64 timeout__, GLenum& status__)
+    {
+        __GLW_HANDLE(status__ = glClientWaitSync(slot__.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout__)) {
+            return handle_error(__GLW_LAST_ERROR, "glClientWaitSync");
+        }
+        if(status__ == GL_WAIT_FAILED) {
+            return handle_error(GL_INVALID_OPERATION, "glClientWaitSync");
+        }
+        if(status__ != GL_TIMEOUT_EXPIRED) {
+            glDeleteSync(slot__.fence);
+            slot__.fence = 0;
+        }
+        return GL_NO_ERROR;
+    }
+
+    GLuint wait(Slot& slot__)
+    {
+        GLenum status = GL_TIMEOUT_EXPIRED;
+        GLuint error = GL_NO_ERROR;
+        while(slot__.fence && error == GL_NO_ERROR) {
+            error = clientWait(slot__, 1000000, status);
+        }
+        return error;
+    }
+
+    GLuint fence(Slot& slot__)
+    {
+        __GLW_HANDLE(slot__.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)) {
+            return handle_error(__GLW_LAST_ERROR, "glFenceSync");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Waits for the slot's previous transfer and makes sure its buffer
+    // holds size__ bytes.
+    GLuint prepare(Slot& slot__, const GLenum target__, const GLenum usage__, const size_t size__)
+    {
+        GLuint error;
+        if((error = wait(slot__)) != GL_NO_ERROR) {
+            return error;
+        }
+        if(!slot__.buffer || slot__.buffer->size() < size__) {
+            delete slot__.buffer;
+            error = GL_NO_ERROR;
+            slot__.buffer = new BasicBuffer<ErrorPolicy>(target__, usage__, size__, NULL, &error);
+            if(error != GL_NO_ERROR) {
+                return error;
+            }
+        }
+        slot__.size = size__;
+        return GL_NO_ERROR;
+    }
+
+    static void release(Slots& slots__)
+    {
+        for(size_t i = 0; i < slots__.size(); ++i) {
+            if(slots__[i].fence) glDeleteSync(slots__[i].fence);
+            delete slots__[i].buffer;
+        }
+    }
+
+public:
+    BasicPixelTransfer(const size_t buffers__ = 3)
+      : next_pack_(0),
+        next_unpack_(0)
+    {
+        Slot slot = { NULL, 0, 0 };
+        pack_.resize(buffers__, slot);
+        unpack_.resize(buffers__, slot);
+    }
+
+    ~BasicPixelTransfer()
+    {
+        release(pack_);
+        release(unpack_);
+    }
+
+    // Copies data__ into the next unpack buffer and updates the texture
+    // from it without waiting for the upload to complete.
+    GLuint upload(
+        BasicTexture2D<ErrorPolicy>& texture__,
+        const GLint lod__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const void* data__)
+    {
+        Slot& slot = unpack_[next_unpack_];
+        next_unpack_ = (next_unpack_ + 1) % unpack_.size();
+
+        GLint alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        const size_t size = sizeof_image(format__, size_x__, size_y__, 1, alignment);
+
+        GLuint error;
+        void* mem;
+        if((error = prepare(slot, GL_PIXEL_UNPACK_BUFFER, GL_STREAM_DRAW, size)) != GL_NO_ERROR) {
+            return error;
+        }
+        mem = slot.buffer->map(
+            0,
+            size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT,
+            &error);
+        if(!mem) {
+            return error;
+        }
+        memcpy(mem, data__, size);
+        if((error = slot.buffer->unmap()) != GL_NO_ERROR) {
+            return error;
+        }
+        if((error = slot.buffer->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        error = texture__.write(lod__, format__, offset_x__, offset_y__, size_x__, size_y__, NULL);
+        StateCache::current().bindBuffer<ErrorPolicy>(GL_PIXEL_UNPACK_BUFFER, 0);
+        if(error != GL_NO_ERROR) {
+            return error;
+        }
+        return fence(slot);
+    }
+
+    // Starts reading a region of the texture into the next pack buffer and
+    // stores the handle to pass to ready() and endRead() in transfer__.
+    GLuint beginRead(
+        BasicTexture2D<ErrorPolicy>& texture__,
+        const GLint lod__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        size_t& transfer__)
+    {
+        transfer__ = next_pack_;
+        Slot& slot = pack_[next_pack_];
+        next_pack_ = (next_pack_ + 1) % pack_.size();
+
+        GLint alignment = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+        const size_t size = sizeof_image(format__, size_x__, size_y__, 1, alignment);
+
+        GLuint error;
+        if((error = prepare(slot, GL_PIXEL_PACK_BUFFER, GL_STREAM_READ, size)) != GL_NO_ERROR) {
+            return error;
+        }
+        if((error = slot.buffer->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        error = texture__.read(lod__, format__, offset_x__, offset_y__, size_x__, size_y__, NULL);
+        StateCache::current().bindBuffer<ErrorPolicy>(GL_PIXEL_PACK_BUFFER, 0);
+        if(error != GL_NO_ERROR) {
+            return error;
+        }
+        return fence(slot);
+    }
+
+    // Polls a read without blocking.
+    bool ready(const size_t transfer__)
+    {
+        if(transfer__ >= pack_.size()) {
+            return false;
+        }
+        Slot& slot = pack_[transfer__];
+        GLenum status = GL_ALREADY_SIGNALED;
+        if(slot.fence && clientWait(slot, 0, status) != GL_NO_ERROR) {
+            return false;
+        }
+        return status != GL_TIMEOUT_EXPIRED;
+    }
+
+    // Fetches a read, waiting for it if it is still pending.
+    GLuint endRead(const size_t transfer__, void* data__)
+    {
+        if(transfer__ >= pack_.size() || !pack_[transfer__].buffer) {
+            return handle_error(GL_INVALID_OPERATION, "PixelTransfer::endRead");
+        }
+        Slot& slot = pack_[transfer__];
+        GLuint error;
+        if((error = wait(slot)) != GL_NO_ERROR) {
+            return error;
+        }
+        // Reading binds the pack buffer, which would turn the pointers of
+        // later client memory reads into offsets in it.
+        error = slot.buffer->read(0, slot.size, data__);
+        StateCache::current().bindBuffer<ErrorPolicy>(GL_PIXEL_PACK_BUFFER, 0);
+        return error;
+    }
+
+    size_t buffers() const { return pack_.size(); }
+};
+
+typedef BasicPixelTransfer<> PixelTransfer;
+
+} // namespace
+
+#endif
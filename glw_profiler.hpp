@@ -0,0 +1,435 @@
+
+#ifndef __GLW_PROFILER_HPP
+#define __GLW_PROFILER_HPP
+
+#include "glw.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+
+namespace glw {
+
+// Frame profiler of nested named scopes, timed on the CPU and, with GL 3.3
+// or ARB_timer_query, on the GPU. Each scope writes a GL_TIMESTAMP query at
+// its beginning and end; GL_TIME_ELAPSED queries cannot nest. Results are
+// read latency__ frames after endFrame(), and only once available, so the
+// profiler never waits on the GPU. Frames still pending after twice the
+// latency are dropped instead.
+//
+// Scope names must outlive the profiler, e.g. string literals.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicProfiler
+{
+public:
+    // Times are in nanoseconds since the profiler was created. GPU times
+    // are moved to the CPU clock; both are 0 without timer queries.
+    struct Event
+    {
+        const GLchar* name;
+        GLint depth;
+        GLuint64 frame;
+        GLint64 cpu_begin;
+        GLint64 cpu_end;
+        GLint64 gpu_begin;
+        GLint64 gpu_end;
+    };
+
+    struct Summary
+    {
+        std::string name;
+        size_t count;
+        GLuint64 cpu_nanoseconds;
+        GLuint64 gpu_nanoseconds;
+    };
+
+    // Calls of a wrapper method timed by __GLW_PROFILE on this thread.
+    struct Calls
+    {
+        std::string name;
+        size_t calls;
+        GLuint64 nanoseconds;
+    };
+
+    class Scope
+    {
+    private:
+        BasicProfiler& profiler_;
+
+        Scope(const Scope&);
+
+    public:
+        Scope(BasicProfiler& profiler__, const GLchar* name__)
+          : profiler_(profiler__)
+        {
+            profiler_.begin(name__);
+        }
+
+        ~Scope()
+        {
+            profiler_.end();
+        }
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const GLuint debug_source = SOURCE_PROFILER;
+    static const GLsizei query_block = 64;
+
+    struct Record
+    {
+        const GLchar* name;
+        GLint depth;
+        GLint64 cpu_begin;
+        GLint64 cpu_end;
+        GLuint query_begin;
+        GLuint query_end;
+    };
+
+    struct Frame
+    {
+        GLuint64 index;
+        std::vector<Record> records;
+        // Query of the last timestamp written in the frame, usually the
+        // end of the frame scope.
+        GLuint last_query;
+    };
+
+    std::vector<GLuint> queries_;
+    std::vector<GLuint> free_queries_;
+    std::deque<Frame> pending_;
+    Frame current_;
+    std::vector<size_t> open_;
+    std::deque<Event> events_;
+    size_t capacity_;
+    GLuint latency_;
+    bool timer_;
+    Clock::time_point origin_;
+    GLint64 gpu_offset_;
+
+    BasicProfiler(const BasicProfiler&);
+
+    GLint64 now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin_).count();
+    }
+
+    GLuint acquireQuery(GLuint& query__)
+    {
+        if(free_queries_.empty()) {
+            const size_t size = queries_.size();
+            queries_.resize(size + query_block);
+            __GLW_HANDLE(glGenQueries(query_block, &queries_[size])) {
+                queries_.resize(size);
+                return handle_error(__GLW_LAST_ERROR, "glGenQueries");
+            }
+            free_queries_.assign(queries_.begin() + size, queries_.end());
+        }
+        query__ = free_queries_.back();
+        free_queries_.pop_back();
+        return GL_NO_ERROR;
+    }
+
+    GLuint timestamp(GLuint& query__)
+    {
+        query__ = 0;
+        if(!timer_) {
+            return GL_NO_ERROR;
+        }
+        GLuint error;
+        if((error = acquireQuery(query__)) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glQueryCounter(query__, GL_TIMESTAMP)) {
+            free_queries_.push_back(query__);
+            query__ = 0;
+            return handle_error(__GLW_LAST_ERROR, "glQueryCounter");
+        }
+        current_.last_query = query__;
+        return GL_NO_ERROR;
+    }
+
+    void release(Frame& frame__)
+    {
+        for(size_t i = 0; i < frame__.records.size(); ++i) {
+            if(frame__.records[i].query_begin) free_queries_.push_back(frame__.records[i].query_begin);
+            if(frame__.records[i].query_end) free_queries_.push_back(frame__.records[i].query_end);
+        }
+    }
+
+    // True once the last query written in frame__ has a result; queries
+    // complete in order, so the others have one too.
+    bool available(const Frame& frame__) const
+    {
+        if(!frame__.last_query) {
+            return true;
+        }
+        GLuint result = GL_FALSE;
+        glGetQueryObjectuiv(frame__.last_query, GL_QUERY_RESULT_AVAILABLE, &result);
+        return result == GL_TRUE;
+    }
+
+    GLint64 gpuTime(const GLuint query__) const
+    {
+        if(!query__) {
+            return 0;
+        }
+        GLuint64 result = 0;
+        glGetQueryObjectui64v(query__, GL_QUERY_RESULT, &result);
+        return (GLint64)result - gpu_offset_;
+    }
+
+    void retire(Frame& frame__)
+    {
+        for(size_t i = 0; i < frame__.records.size(); ++i) {
+            const Record& record = frame__.records[i];
+            const Event event = {
+                record.name,
+                record.depth,
+                frame__.index,
+                record.cpu_begin,
+                record.cpu_end,
+                gpuTime(record.query_begin),
+                gpuTime(record.query_end) };
+            events_.push_back(event);
+        }
+        while(events_.size() > capacity_) {
+            events_.pop_front();
+        }
+        release(frame__);
+    }
+
+    static void escape(std::string& out__, const std::string& text__)
+    {
+        for(size_t i = 0; i < text__.size(); ++i) {
+            const GLchar c = text__[i];
+            if(c == '"' || c == '\\') {
+                out__ += '\\';
+                out__ += c;
+            } else if((unsigned char)c < 0x20) {
+                GLchar code[8];
+                snprintf(code, sizeof(code), "\\u%04x", c);
+                out__ += code;
+            } else {
+                out__ += c;
+            }
+        }
+    }
+
+    static void traceEvent(
+        std::string& out__,
+        const GLchar* name__,
+        const GLint thread__,
+        const GLint64 begin__,
+        const GLint64 end__)
+    {
+        GLchar times[64];
+        snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", begin__ / 1000.0, (end__ - begin__) / 1000.0);
+        out__ += out__.empty() ? "{\"traceEvents\":[\n" : ",\n";
+        out__ += "{\"name\":\"";
+        escape(out__, name__);
+        out__ += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+        out__ += thread__ == 1 ? "1," : "2,";
+        out__ += times;
+        out__ += "}";
+    }
+
+public:
+    BasicProfiler(const GLuint latency__ = 3, const size_t capacity__ = 4096)
+      : capacity_(capacity__),
+        latency_(latency__),
+        timer_(has_version(3, 3) || has_extension("GL_ARB_timer_query")),
+        origin_(Clock::now()),
+        gpu_offset_(0)
+    {
+        current_.index = 0;
+        current_.last_query = 0;
+        calibrate();
+    }
+
+    ~BasicProfiler()
+    {
+        if(!queries_.empty()) {
+            glDeleteQueries(queries_.size(), &queries_[0]);
+        }
+    }
+
+    // Measures the offset between the GPU and CPU clocks. GPU clocks drift
+    // and may reset, e.g. when the GPU idles, so long sessions should call
+    // this now and then.
+    GLuint calibrate()
+    {
+        if(!timer_) {
+            return GL_NO_ERROR;
+        }
+        GLint64 gpu = 0;
+        __GLW_HANDLE(glGetInteger64v(GL_TIMESTAMP, &gpu)) {
+            return handle_error(__GLW_LAST_ERROR, "glGetInteger64v");
+        }
+        gpu_offset_ = gpu - now();
+        return GL_NO_ERROR;
+    }
+
+    // Opens a scope nested in the open ones.
+    GLuint begin(const GLchar* name__)
+    {
+        const Record record = { name__, (GLint)open_.size(), now(), 0, 0, 0 };
+        open_.push_back(current_.records.size());
+        current_.records.push_back(record);
+        return timestamp(current_.records.back().query_begin);
+    }
+
+    GLuint end()
+    {
+        if(open_.empty()) {
+            return handle_error(GL_INVALID_OPERATION, "Profiler::end");
+        }
+        Record& record = current_.records[open_.back()];
+        open_.pop_back();
+        record.cpu_end = now();
+        return timestamp(record.query_end);
+    }
+
+    // Collects the frames that are old enough and opens a scope around the
+    // new frame.
+    GLuint beginFrame(const GLchar* name__ = "Frame")
+    {
+        collect();
+        return begin(name__);
+    }
+
+    // Closes the frame scope opened by beginFrame().
+    GLuint endFrame()
+    {
+        const GLuint error = end();
+        while(!open_.empty()) {
+            end();
+        }
+        const GLuint64 index = current_.index;
+        pending_.push_back(current_);
+        current_.records.clear();
+        current_.index = index + 1;
+        current_.last_query = 0;
+
+        // Too far behind; drop rather than wait.
+        while(pending_.size() > std::max<size_t>(2 * latency_, 1)) {
+            release(pending_.front());
+            pending_.pop_front();
+        }
+        return error;
+    }
+
+    // Reads the results of pending frames without waiting on the GPU.
+    void collect()
+    {
+        while(!pending_.empty() &&
+            current_.index - pending_.front().index >= latency_ &&
+            available(pending_.front())) {
+            retire(pending_.front());
+            pending_.pop_front();
+        }
+    }
+
+    // Waits for the results of every ended frame, e.g. before exiting.
+    void finish()
+    {
+        while(!pending_.empty()) {
+            retire(pending_.front());
+            pending_.pop_front();
+        }
+    }
+
+    void clear()
+    {
+        events_.clear();
+    }
+
+    const std::deque<Event>& events() const { return events_; }
+    bool hasTimer() const { return timer_; }
+    GLuint latency() const { return latency_; }
+    GLuint64 frame() const { return current_.index; }
+
+    // Totals of the collected events by scope name.
+    std::vector<Summary> summary() const
+    {
+        std::map<std::string, Summary> totals;
+        for(size_t i = 0; i < events_.size(); ++i) {
+            const Event& event = events_[i];
+            Summary& total = totals[event.name];
+            if(total.name.empty()) {
+                total.name = event.name;
+                total.count = 0;
+                total.cpu_nanoseconds = 0;
+                total.gpu_nanoseconds = 0;
+            }
+            ++total.count;
+            total.cpu_nanoseconds += event.cpu_end - event.cpu_begin;
+            total.gpu_nanoseconds += event.gpu_end - event.gpu_begin;
+        }
+        std::vector<Summary> result;
+        for(typename std::map<std::string, Summary>::const_iterator i = totals.begin(); i != totals.end(); ++i) {
+            result.push_back(i->second);
+        }
+        return result;
+    }
+
+    // The collected events in the Chrome trace event format, for
+    // chrome://tracing or Perfetto: CPU scopes on thread 1, GPU on 2.
+    std::string chromeTrace() const
+    {
+        std::string result;
+        for(size_t i = 0; i < events_.size(); ++i) {
+            const Event& event = events_[i];
+            traceEvent(result, event.name, 1, event.cpu_begin, event.cpu_end);
+            if(timer_) {
+                traceEvent(result, event.name, 2, event.gpu_begin, event.gpu_end);
+            }
+        }
+        result += result.empty() ? "{\"traceEvents\":[\n" : ",\n";
+        result +=
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}\n"
+            "]}\n";
+        return result;
+    }
+
+    // Calls and CPU time of each wrapper method on this thread, by name.
+    // Empty unless built with __GLW_ENABLE_PROFILER, which adds about 50 ns
+    // to every wrapper method call (see __GLW_PROFILE in glw.hpp).
+    static std::vector<Calls> calls()
+    {
+        std::vector<Calls> result;
+#ifdef __GLW_ENABLE_PROFILER
+        std::map<std::string, size_t> index;
+        const std::vector<CallTime>& times = call_times();
+        std::lock_guard<std::mutex> lock(profile_mutex());
+        for(size_t i = 0; i < times.size(); ++i) {
+            if(!times[i].calls) continue;
+            const std::string name = profile_sites()[i];
+            if(index.find(name) == index.end()) {
+                const Calls zero = { name, 0, 0 };
+                index[name] = result.size();
+                result.push_back(zero);
+            }
+            result[index[name]].calls += times[i].calls;
+            result[index[name]].nanoseconds += times[i].nanoseconds;
+        }
+#endif
+        return result;
+    }
+
+    static void resetCalls()
+    {
+#ifdef __GLW_ENABLE_PROFILER
+        call_times().clear();
+#endif
+    }
+};
+
+typedef BasicProfiler<> Profiler;
+
+} // namespace
+
+#endif
@@ -2,6 +2,10 @@
 #define __GLW_PROGRAM_HPP
 
 #include "glw.hpp"
+#include "glw_vertex_layout.hpp"
+
+#include <algorithm>
+#include <map>
 
 namespace glw {
 
@@ -22,30 +26,65 @@ private:
     std::string log_;
 };
 
-class Program : public Wrapper
+// Layout of a uniform block as reflected from a linked program. Offsets
+// and strides are in bytes; size is the array length of a member.
+struct BlockMember
+{
+    std::string name;
+    GLint offset;
+    GLint size;
+    GLenum type;
+    GLint array_stride;
+    GLint matrix_stride;
+    // Matrices stored a row, rather than a column, per matrix_stride.
+    bool row_major;
+};
+
+struct BlockLayout
+{
+    std::string name;
+    GLuint index;
+    GLint size;
+    GLuint binding;
+    std::vector<BlockMember> members;
+};
+
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicProgram : public Wrapper
 {
 public:
     struct Attribute
     {
-        static const size_t name_size = 32;
-        char name[name_size];
+        std::string name;
+        GLint location;
         GLint size;
         GLenum type;
         size_t stride;
         size_t offset;
         GLuint buffer;
-        bool dirty;
+        GLuint divisor;
+        // Format of the data in the buffer, derived from type if 0.
+        GLint components;
+        GLenum component_type;
+        GLboolean normalized;
     };
 
     struct Uniform
     {
-        static const size_t name_size = 32;
-        char name[name_size];
+        std::string name;
+        GLint location;
         GLint size;
         GLenum type;
         GLuint texture;
-        std::vector<GLubyte> data;
-        bool dirty;
+        size_t offset;
+        size_t bytes;
+        bool uploaded;
+    };
+
+    struct UniformStats
+    {
+        size_t uploads;
+        size_t skipped;
     };
 
     struct Shader
@@ -53,29 +92,229 @@ public:
         GLenum type;
         const GLchar* source;
     };
+
+    // Resolved once by name and then used by the setters without any string
+    // handling. Handles stay valid until the next build().
+    struct AttributeHandle
+    {
+        GLint index;
+        bool valid() const { return index >= 0; }
+    };
+
+    struct UniformHandle
+    {
+        GLint index;
+        bool valid() const { return index >= 0; }
+    };
     
     typedef std::vector<Attribute> Attributes;
     typedef std::vector<Uniform> Uniforms;
     typedef std::vector<Shader> Shaders;
+    typedef std::vector<BlockLayout> Blocks;
    
 private:
+    struct NameEntry
+    {
+        size_t hash;
+        GLint index;
+
+        bool operator<(const NameEntry& other__) const { return hash < other__.hash; }
+    };
+
+    typedef std::vector<NameEntry> NameIndex;
+
+    // Attribute bindings a vertex array object was configured with.
+    struct VertexBinding
+    {
+        GLuint buffer;
+        size_t stride;
+        size_t offset;
+        GLenum type;
+        GLuint divisor;
+        GLint components;
+        GLenum component_type;
+        GLboolean normalized;
+
+        bool operator<(const VertexBinding& other__) const
+        {
+            if(buffer != other__.buffer) return buffer < other__.buffer;
+            if(stride != other__.stride) return stride < other__.stride;
+            if(offset != other__.offset) return offset < other__.offset;
+            if(type != other__.type) return type < other__.type;
+            if(divisor != other__.divisor) return divisor < other__.divisor;
+            if(components != other__.components) return components < other__.components;
+            if(component_type != other__.component_type) return component_type < other__.component_type;
+            return normalized < other__.normalized;
+        }
+    };
+
+    typedef std::vector<VertexBinding> VertexArrayKey;
+
+    struct VertexArray
+    {
+        GLuint name;
+        // Value of vertex_array_uses_ when last bound.
+        GLuint64 used;
+    };
+
+    typedef std::map<VertexArrayKey, VertexArray> VertexArrays;
+
+    static const GLuint debug_source = SOURCE_PROGRAM;
+
     Shaders sources_;
     Attributes attributes_;
     Uniforms uniforms_;
+    Blocks blocks_;
+    std::vector<GLubyte> uniform_data_;
+    std::vector<GLuint64> uniform_dirty_;
+    std::vector<GLint> samplers_;
+    size_t uniform_shadow_;
+    NameIndex attribute_names_;
+    NameIndex uniform_names_;
+    UniformStats uniform_stats_;
+    VertexArrays vertex_arrays_;
+    GLuint64 vertex_array_uses_;
+    // StateCache::bufferDeletions() when the vertex arrays were checked.
+    GLuint64 buffer_deletions_;
+    GLuint vertex_array_;
+    bool vertex_array_dirty_;
+    bool linking_;
+    bool parallel_;
+    bool retrievable_;
 
+    static size_t hashName(const GLchar* name__, size_t length__)
+    {
+        // FNV-1a.
+        size_t hash = 2166136261u;
+        for(size_t i = 0; i < length__; ++i) {
+            hash = (hash ^ (GLubyte)name__[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Matches name__ against an active resource name, accepting "a" for the
+    // first element "a[0]" of an array.
+    static bool matchName(const std::string& active__, const GLchar* name__, size_t length__)
+    {
+        if(active__.compare(0, std::string::npos, name__, length__) == 0) {
+            return true;
+        }
+        return active__.size() == length__ + 3
+            && active__.compare(0, length__, name__, length__) == 0
+            && active__.compare(length__, 3, "[0]") == 0;
+    }
+
+    template <typename T>
+    static void indexNames(const std::vector<T>& items__, NameIndex& names__)
+    {
+        names__.clear();
+        for(size_t i = 0; i < items__.size(); ++i) {
+            const std::string& name = items__[i].name;
+            NameEntry entry = { hashName(name.c_str(), name.size()), (GLint)i };
+            names__.push_back(entry);
+            if(name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+                entry.hash = hashName(name.c_str(), name.size() - 3);
+                names__.push_back(entry);
+            }
+        }
+        std::sort(names__.begin(), names__.end());
+    }
+
+    template <typename T>
+    static GLint findName(const std::vector<T>& items__, const NameIndex& names__, const GLchar* name__)
+    {
+        const size_t length = strlen(name__);
+        NameEntry key = { hashName(name__, length), -1 };
+        typename NameIndex::const_iterator it = std::lower_bound(names__.begin(), names__.end(), key);
+        for(; it != names__.end() && it->hash == key.hash; ++it) {
+            if(matchName(items__[it->index].name, name__, length)) {
+                return it->index;
+            }
+        }
+        return -1;
+    }
+
+    // Binds the vertex array object matching the current attribute
+    // bindings, creating it on first use.
     GLuint prepareAttributes()
     {
+        const GLuint64 buffer_deletions = StateCache::current().bufferDeletions();
+        if(buffer_deletions != buffer_deletions_) {
+            clearVertexArrays();
+            buffer_deletions_ = buffer_deletions;
+        }
+        if(vertex_array_dirty_) {
+            VertexArrayKey key(attributes_.size());
+            for(int i = 0; i < attributes_.size(); ++i) {
+                key[i].buffer = attributes_[i].buffer;
+                key[i].stride = attributes_[i].stride;
+                key[i].offset = attributes_[i].offset;
+                key[i].type = attributes_[i].type;
+                key[i].divisor = attributes_[i].divisor;
+                key[i].components = attributes_[i].components;
+                key[i].component_type = attributes_[i].component_type;
+                key[i].normalized = attributes_[i].normalized;
+            }
+
+            typename VertexArrays::iterator it = vertex_arrays_.find(key);
+            if(it == vertex_arrays_.end()) {
+                if(vertex_arrays_.size() >= max_vertex_arrays) {
+                    evictVertexArray();
+                }
+                VertexArray vertex_array = { 0, 0 };
+                GLuint error;
+                __GLW_HANDLE(glGenVertexArrays(1, &vertex_array.name)) {
+                    return handle_error(__GLW_LAST_ERROR, "glGenVertexArrays");
+                }
+                if((error = setupVertexArray(vertex_array.name)) != GL_NO_ERROR) {
+                    StateCache::current().forgetVertexArray(vertex_array.name);
+                    glDeleteVertexArrays(1, &vertex_array.name);
+                    return error;
+                }
+                it = vertex_arrays_.insert(std::make_pair(key, vertex_array)).first;
+            }
+            it->second.used = ++vertex_array_uses_;
+            vertex_array_ = it->second.name;
+            vertex_array_dirty_ = false;
+        }
+
+        return StateCache::current().bindVertexArray<ErrorPolicy>(vertex_array_);
+    }
+
+    void evictVertexArray()
+    {
+        typename VertexArrays::iterator oldest = vertex_arrays_.begin();
+        typename VertexArrays::iterator it;
+        for(it = vertex_arrays_.begin(); it != vertex_arrays_.end(); ++it) {
+            if(it->second.used < oldest->second.used) oldest = it;
+        }
+        StateCache::current().forgetVertexArray(oldest->second.name);
+        glDeleteVertexArrays(1, &oldest->second.name);
+        vertex_arrays_.erase(oldest);
+    }
+
+    GLuint setupVertexArray(const GLuint vertex_array__)
+    {
+        StateCache& state = StateCache::current();
         Attribute* attribute;
         GLenum type;
         GLint size;
+        GLuint error;
+
+        if((error = state.bindVertexArray<ErrorPolicy>(vertex_array__)) != GL_NO_ERROR) {
+            return error;
+        }
 
         for(int i = 0; i < attributes_.size(); ++i) {
             attribute = &attributes_[i];
-            if(!attribute->dirty) continue;
+            if(!attribute->buffer) continue;
 
             #define __GLW_IMPL_ATTRIB_TRANS(ContainerType, DataType, Size) \
                 case ContainerType: type = DataType; size = Size; break;
-            switch(attribute->type) {
+            if(attribute->components) {
+                type = attribute->component_type;
+                size = attribute->components;
+            } else switch(attribute->type) {
             __GLW_IMPL_ATTRIB_TRANS(GL_FLOAT,               GL_FLOAT,           1);
             __GLW_IMPL_ATTRIB_TRANS(GL_FLOAT_VEC2,          GL_FLOAT,           2);
             __GLW_IMPL_ATTRIB_TRANS(GL_FLOAT_VEC3,          GL_FLOAT,           3);
@@ -85,75 +324,182 @@ private:
             __GLW_IMPL_ATTRIB_TRANS(GL_INT_VEC3,            GL_INT,             3);
             __GLW_IMPL_ATTRIB_TRANS(GL_INT_VEC4,            GL_INT,             4);
             __GLW_IMPL_ATTRIB_TRANS(GL_UNSIGNED_INT,        GL_UNSIGNED_INT,    1);
-            default: return handle_error(GL_INVALID_OPERATION, "Program::prepareAttributes");
+            __GLW_IMPL_ATTRIB_TRANS(GL_UNSIGNED_INT_VEC2,   GL_UNSIGNED_INT,    2);
+            __GLW_IMPL_ATTRIB_TRANS(GL_UNSIGNED_INT_VEC3,   GL_UNSIGNED_INT,    3);
+            __GLW_IMPL_ATTRIB_TRANS(GL_UNSIGNED_INT_VEC4,   GL_UNSIGNED_INT,    4);
+            default: return handle_error(GL_INVALID_OPERATION, "Program::setupVertexArray");
             }
 
-            __GLW_HANDLE(glBindBuffer(GL_ARRAY_BUFFER, attribute->buffer)) {
-                return handle_error(__GLW_LAST_ERROR, "glBindBuffer");
+            if((error = state.bindBuffer<ErrorPolicy>(GL_ARRAY_BUFFER, attribute->buffer)) != GL_NO_ERROR) {
+                return error;
             }
-            __GLW_HANDLE(glVertexAttribPointer(
-                i,
-                size,
-                type,
-                GL_FALSE,
-                attribute->stride,
-                (void*)attribute->offset)) {
-                return handle_error(__GLW_LAST_ERROR, "glVertexAttribPointer");
+
+            // Integer inputs must not be converted to floats on the way.
+            switch(attribute->type) {
+            case GL_INT:
+            case GL_INT_VEC2:
+            case GL_INT_VEC3:
+            case GL_INT_VEC4:
+            case GL_UNSIGNED_INT:
+            case GL_UNSIGNED_INT_VEC2:
+            case GL_UNSIGNED_INT_VEC3:
+            case GL_UNSIGNED_INT_VEC4:
+                __GLW_HANDLE(glVertexAttribIPointer(
+                    attribute->location,
+                    size,
+                    type,
+                    attribute->stride,
+                    (void*)attribute->offset)) {
+                    return handle_error(__GLW_LAST_ERROR, "glVertexAttribIPointer");
+                }
+                break;
+            default:
+                __GLW_HANDLE(glVertexAttribPointer(
+                    attribute->location,
+                    size,
+                    type,
+                    attribute->components ? attribute->normalized : GL_FALSE,
+                    attribute->stride,
+                    (void*)attribute->offset)) {
+                    return handle_error(__GLW_LAST_ERROR, "glVertexAttribPointer");
+                }
+                break;
             }
-            __GLW_HANDLE(glEnableVertexAttribArray(i)) {
+            __GLW_HANDLE(glEnableVertexAttribArray(attribute->location)) {
                 return handle_error(__GLW_LAST_ERROR, "glEnableVertexAttribArray");
             }
-            attribute->dirty = false;
+            if(attribute->divisor) {
+                __GLW_HANDLE(glVertexAttribDivisor(attribute->location, attribute->divisor)) {
+                    return handle_error(__GLW_LAST_ERROR, "glVertexAttribDivisor");
+                }
+            }
         }
 
         return GL_NO_ERROR;
     }
 
+    static GLuint lowestBit(GLuint64 word__)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(word__);
+#else
+        GLuint bit = 0;
+        while(!(word__ & 1)) {
+            word__ >>= 1;
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    bool isDirty(const GLint index__) const
+    {
+        return (uniform_dirty_[index__ / 64] >> (index__ % 64)) & 1;
+    }
+
+    void setDirty(const GLint index__)
+    {
+        uniform_dirty_[index__ / 64] |= (GLuint64)1 << (index__ % 64);
+    }
+
     GLuint prepareUniforms()
     {
         Uniform* uniform;
         GLenum texture_type;
+        GLuint error;
+        size_t element;
+        GLint first;
+        GLint last;
 
-        for(int i = 0; i < uniforms_.size(); ++i) {
-            uniform = &uniforms_[i];
-            if(!uniform->dirty) continue;
+        // Texture units are shared with other programs, so samplers check
+        // their texture binding on every draw.
+        for(size_t i = 0; i < samplers_.size(); ++i) {
+            uniform = &uniforms_[samplers_[i]];
 
-            texture_type = 0;
-            switch(uniform->type) {
-            //case GL_SAMPLER_1D: texture_type = GL_TEXTURE_1D; break;
-            case GL_SAMPLER_2D: texture_type = GL_TEXTURE_2D; break;
-            //case GL_SAMPLER_3D: texture_type = GL_TEXTURE_3D; break;
+            texture_type = sampler_target(uniform->type);
+            if(uniform->texture != 0) {
+                if((error = StateCache::current().bindTexture<ErrorPolicy>(
+                    *reinterpret_cast<const GLint*>(&uniform_data_[uniform->offset]),
+                    texture_type,
+                    uniform->texture)) != GL_NO_ERROR) {
+                    return error;
+                }
             }
+        }
+
+        // Visit dirty uniforms only, a word of the bitset at a time. A bit
+        // is cleared once its uniform is up to date, so that those left
+        // after a failed upload are retried by the next draw.
+        for(size_t word = 0; word < uniform_dirty_.size(); ++word) {
+            GLuint64 bits = uniform_dirty_[word];
+            for(; bits; bits &= bits - 1) {
+                const GLuint64 bit = bits & ~(bits - 1);
+                uniform = &uniforms_[word * 64 + lowestBit(bits)];
 
-            if(texture_type != 0) {
-                 __GLW_HANDLE(glActiveTexture(GL_TEXTURE0 + *reinterpret_cast<GLint*>(uniform->data.data()))) {
-                    return handle_error(__GLW_LAST_ERROR, "glActiveTexture");
+                // Upload only the array elements that differ from the values
+                // last sent to GL.
+                const GLubyte* data = &uniform_data_[uniform->offset];
+                const GLubyte* shadow = &uniform_data_[uniform_shadow_ + uniform->offset];
+                element = uniform->bytes / uniform->size;
+                first = 0;
+                last = uniform->size - 1;
+                if(uniform->uploaded) {
+                    while(first <= last && memcmp(
+                        data + first * element,
+                        shadow + first * element,
+                        element) == 0) ++first;
+                    while(last > first && memcmp(
+                        data + last * element,
+                        shadow + last * element,
+                        element) == 0) --last;
                 }
-                __GLW_HANDLE(glBindTexture(texture_type, uniform->texture)) {
-                    return handle_error(__GLW_LAST_ERROR, "glBindTexture");
+                if(first > last) {
+                    uniform_dirty_[word] &= ~bit;
+                    ++uniform_stats_.skipped;
+                    continue;
                 }
-            }
 
-            #define __GLW_IMPL_UNIFORM_TRANS(ContainerType, Function, Cast) \
-                case ContainerType: __GLW_HANDLE(Function(i, uniform->size, reinterpret_cast<Cast>(&uniform->data[0]))) { \
-                    return handle_error(__GLW_LAST_ERROR, #Function); } break;
-            #define __GLW_IMPL_UNIFORM_TRANS_MAT(ContainerType, Function, Cast) \
-                case ContainerType: __GLW_HANDLE(Function(i, uniform->size, GL_FALSE, reinterpret_cast<Cast>(&uniform->data[0]))) { \
-                    return handle_error(__GLW_LAST_ERROR, #Function); } break;
-            switch(uniform->type) {
-            __GLW_IMPL_UNIFORM_TRANS(GL_SAMPLER_2D,         glUniform1iv,       const GLint*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT,              glUniform1fv,       const GLfloat*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT_VEC2,         glUniform2fv,       const GLfloat*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT_VEC3,         glUniform3fv,       const GLfloat*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT_VEC4,         glUniform4fv,       const GLfloat*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_INT,                glUniform1iv,       const GLint*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_INT_VEC2,           glUniform2iv,       const GLint*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_INT_VEC3,           glUniform3iv,       const GLint*);
-            __GLW_IMPL_UNIFORM_TRANS(GL_INT_VEC4,           glUniform4iv,       const GLint*);
-            __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT2,     glUniformMatrix2fv, const GLfloat*);
-            __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT3,     glUniformMatrix3fv, const GLfloat*);
-            __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT4,     glUniformMatrix4fv, const GLfloat*);
-            default: return handle_error(GL_INVALID_OPERATION, "Program::prepareUniforms");
+                #define __GLW_IMPL_UNIFORM_TRANS(ContainerType, Function, Cast) \
+                    case ContainerType: __GLW_HANDLE(Function(uniform->location + first, last - first + 1, reinterpret_cast<Cast>(data + first * element))) { \
+                        return handle_error(__GLW_LAST_ERROR, #Function); } break;
+                #define __GLW_IMPL_UNIFORM_TRANS_MAT(ContainerType, Function, Cast) \
+                    case ContainerType: __GLW_HANDLE(Function(uniform->location + first, last - first + 1, GL_FALSE, reinterpret_cast<Cast>(data + first * element))) { \
+                        return handle_error(__GLW_LAST_ERROR, #Function); } break;
+                // Samplers of every type are set to a texture unit.
+                switch(sampler_target(uniform->type) ? GL_SAMPLER_2D : uniform->type) {
+                __GLW_IMPL_UNIFORM_TRANS(GL_SAMPLER_2D,         glUniform1iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT,              glUniform1fv,       const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT_VEC2,         glUniform2fv,       const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT_VEC3,         glUniform3fv,       const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_FLOAT_VEC4,         glUniform4fv,       const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_INT,                glUniform1iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_INT_VEC2,           glUniform2iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_INT_VEC3,           glUniform3iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_INT_VEC4,           glUniform4iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_UNSIGNED_INT,       glUniform1uiv,      const GLuint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_UNSIGNED_INT_VEC2,  glUniform2uiv,      const GLuint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_UNSIGNED_INT_VEC3,  glUniform3uiv,      const GLuint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_UNSIGNED_INT_VEC4,  glUniform4uiv,      const GLuint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_BOOL,               glUniform1iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_BOOL_VEC2,          glUniform2iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_BOOL_VEC3,          glUniform3iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS(GL_BOOL_VEC4,          glUniform4iv,       const GLint*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT2,     glUniformMatrix2fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT3,     glUniformMatrix3fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT4,     glUniformMatrix4fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT2x3,   glUniformMatrix2x3fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT2x4,   glUniformMatrix2x4fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT3x2,   glUniformMatrix3x2fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT3x4,   glUniformMatrix3x4fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT4x2,   glUniformMatrix4x2fv, const GLfloat*);
+                __GLW_IMPL_UNIFORM_TRANS_MAT(GL_FLOAT_MAT4x3,   glUniformMatrix4x3fv, const GLfloat*);
+                default: return handle_error(GL_INVALID_OPERATION, "Program::prepareUniforms");
+                }
+                memcpy(&uniform_data_[uniform_shadow_ + uniform->offset], data, uniform->bytes);
+                uniform_dirty_[word] &= ~bit;
+                uniform->uploaded = true;
+                ++uniform_stats_.uploads;
+                __GLW_COUNT(uniform_uploads, 1);
             }
         }
 
@@ -161,24 +507,60 @@ private:
     }
 
 public:
-    Program(const Shaders& sources__, GLuint* error = NULL)
-      : sources_(sources__)
+    BasicProgram(const Shaders& sources__, GLuint* error = NULL)
+      : sources_(sources__),
+        uniform_shadow_(0),
+        vertex_array_uses_(0),
+        buffer_deletions_(0),
+        vertex_array_(0),
+        vertex_array_dirty_(true),
+        linking_(false),
+        parallel_(false),
+        retrievable_(false)
     {
+        resetUniformStats();
         __GLW_HANDLE(handle_ = glCreateProgram()) {}
     }
 
-    ~Program()
+    ~BasicProgram()
     {
-        if(handle_) glDeleteProgram(handle_);
+        clearVertexArrays();
+        if(handle_) {
+            StateCache::current().forgetProgram(handle_);
+            glDeleteProgram(handle_);
+        }
     }
     
+    // Compiles and links, blocking until the program is usable. To build
+    // many programs, submit() them all first and finish() them afterwards
+    // (see build_programs()), so the driver can work on them concurrently.
     GLuint build()
+    {
+        GLuint error;
+        if((error = submit()) != GL_NO_ERROR) {
+            return error;
+        }
+        return finish();
+    }
+
+    // Issues the compiles and the link without querying any status.
+    GLuint submit()
     {
         if(sources_.size() == 0) {
-            return handle_error(GL_INVALID_VALUE, "Program::build");
+            return handle_error(GL_INVALID_VALUE, "Program::submit");
         }
 
-        Shaders::iterator it;
+        // Shaders of a previous build are still attached.
+        GLuint attached[16];
+        GLsizei attached_count = 0;
+        do {
+            glGetAttachedShaders(*this, 16, &attached_count, attached);
+            for(GLsizei i = 0; i < attached_count; ++i) {
+                glDetachShader(*this, attached[i]);
+            }
+        } while(attached_count == 16);
+
+        typename Shaders::iterator it;
         for(it = sources_.begin(); it != sources_.end(); ++it) {
             GLint length = strlen(it->source);
             GLuint shader;
@@ -203,84 +585,281 @@ public:
             glDeleteShader(shader);
         }
 
+        if(retrievable_) {
+            __GLW_HANDLE(glProgramParameteri(*this, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE)) {
+                return handle_error(__GLW_LAST_ERROR, "glProgramParameteri");
+            }
+        }
+
         __GLW_HANDLE(glLinkProgram(*this)) {
             return handle_error(__GLW_LAST_ERROR, "glLinkProgram");
         }
 
+        linking_ = true;
+        parallel_ = StateCache::current().supports(StateCache::CAPABILITY_PARALLEL_SHADER_COMPILE);
+        return GL_NO_ERROR;
+    }
+
+    // Whether a submitted link has completed, so that finish() will not
+    // block. Always true without KHR_parallel_shader_compile.
+    bool isReady()
+    {
+        if(!linking_ || !parallel_) {
+            return true;
+        }
+        GLint status = GL_TRUE;
+        __GLW_HANDLE(glGetProgramiv(*this, GL_COMPLETION_STATUS_KHR, &status)) {
+            handle_error(__GLW_LAST_ERROR, "glGetProgramiv");
+            return true;
+        }
+        return status == GL_TRUE;
+    }
+
+    // Checks the result of submit() and reflects attributes and uniforms.
+    GLuint finish()
+    {
+        if(!linking_) {
+            return handle_error(GL_INVALID_OPERATION, "Program::finish");
+        }
+        linking_ = false;
+
         if(getInfo<GL_LINK_STATUS>() == GL_FALSE) {
 #ifdef __GLW_ENABLE_EXCEPTIONS
             throw BuildError(*this, this->log());
 #endif
             return GL_INVALID_OPERATION;
         }
+        return reflect();
+    }
 
-        // Setup attributes.
-        attributes_.resize(getInfo<GL_ACTIVE_ATTRIBUTES>());
-        for(int i = 0; i < getInfo<GL_ACTIVE_ATTRIBUTES>(); ++i) {
-            Attribute attribute = {0};
-            GLuint location;
+    // Links the program from a binary returned by getBinary(). Binaries
+    // rejected by the driver return GL_INVALID_OPERATION, after which the
+    // program can still be built from source.
+    GLuint loadBinary(const GLenum format__, const void* data__, const GLsizei size__)
+    {
+        linking_ = false;
+        __GLW_HANDLE(glProgramBinary(*this, format__, data__, size__)) {
+            return handle_error(__GLW_LAST_ERROR, "glProgramBinary");
+        }
+        if(getInfo<GL_LINK_STATUS>() == GL_FALSE) {
+            return GL_INVALID_OPERATION;
+        }
+        return reflect();
+    }
+
+    GLuint getBinary(GLenum& format__, std::vector<GLubyte>& data__)
+    {
+        data__.resize(getInfo<GL_PROGRAM_BINARY_LENGTH>());
+        if(data__.empty()) {
+            return handle_error(GL_INVALID_OPERATION, "Program::getBinary");
+        }
+        GLsizei length = 0;
+        __GLW_HANDLE(glGetProgramBinary(*this, data__.size(), &length, &format__, &data__[0])) {
+            return handle_error(__GLW_LAST_ERROR, "glGetProgramBinary");
+        }
+        data__.resize(length);
+        return GL_NO_ERROR;
+    }
+
+    // Asks the driver to keep the binary of the next link for getBinary().
+    void setBinaryRetrievable(const bool retrievable__) { retrievable_ = retrievable__; }
+
+    const Shaders& sources() const { return sources_; }
+
+private:
+    GLuint reflect()
+    {
+        std::vector<GLchar> name(1 + std::max(std::max(
+            getInfo<GL_ACTIVE_ATTRIBUTE_MAX_LENGTH>(),
+            getInfo<GL_ACTIVE_UNIFORM_MAX_LENGTH>()),
+            getInfo<GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH>()));
+        GLsizei length;
+
+        clearVertexArrays();
+
+        // Setup attributes. Built-ins have no location and are skipped.
+        const GLint attribute_count = getInfo<GL_ACTIVE_ATTRIBUTES>();
+        attributes_.clear();
+        attributes_.reserve(attribute_count);
+        for(int i = 0; i < attribute_count; ++i) {
+            Attribute attribute = Attribute();
             __GLW_HANDLE(glGetActiveAttrib(
                 *this,
                 i,
-                Attribute::name_size,
-                NULL,
+                name.size(),
+                &length,
                 &attribute.size,
                 &attribute.type,
-                attribute.name)) {
+                &name[0])) {
                 return handle_error(__GLW_LAST_ERROR, "glGetActiveAttrib");
             }
-            __GLW_HANDLE(location = glGetAttribLocation(*this, attribute.name)) {
+            __GLW_HANDLE(attribute.location = glGetAttribLocation(*this, &name[0])) {
                 return handle_error(__GLW_LAST_ERROR, "glGetAttribLocation");
             }
-            attributes_[location] = attribute;
+            if(attribute.location < 0) continue;
+            attribute.name.assign(&name[0], length);
+            attributes_.push_back(attribute);
         }
+        indexNames(attributes_, attribute_names_);
 
-        // Setup uniforms.
-        uniforms_.resize(getInfo<GL_ACTIVE_UNIFORMS>());
-        for(int i = 0; i < getInfo<GL_ACTIVE_UNIFORMS>(); ++i) {
-            Uniform uniform = {0};
-            GLuint location;
+        // Setup uniforms. Block members have no location and are skipped.
+        const GLint uniform_count = getInfo<GL_ACTIVE_UNIFORMS>();
+        uniforms_.clear();
+        uniforms_.reserve(uniform_count);
+        for(int i = 0; i < uniform_count; ++i) {
+            Uniform uniform = Uniform();
             __GLW_HANDLE(glGetActiveUniform(
                 *this,
                 i,
-                Uniform::name_size,
-                NULL,
+                name.size(),
+                &length,
                 &uniform.size,
                 &uniform.type,
-                uniform.name)) {
+                &name[0])) {
                 return handle_error(__GLW_LAST_ERROR, "glGetActiveUniform");
             }
-            __GLW_HANDLE(location = glGetUniformLocation(*this, uniform.name)) {
+            __GLW_HANDLE(uniform.location = glGetUniformLocation(*this, &name[0])) {
                 return handle_error(__GLW_LAST_ERROR, "glGetUniformLocation");
             }
-            uniform.data.resize(sizeof_type(uniform.type) * uniform.size);
-            uniforms_[location] = uniform;
+            if(uniform.location < 0) continue;
+            uniform.name.assign(&name[0], length);
+            uniform.bytes = sizeof_type(uniform.type) * uniform.size;
+            uniforms_.push_back(uniform);
+        }
+        indexNames(uniforms_, uniform_names_);
+
+        // Values and the copies last uploaded share one arena, with every
+        // uniform aligned to 16 bytes.
+        size_t arena_size = 0;
+        samplers_.clear();
+        for(size_t i = 0; i < uniforms_.size(); ++i) {
+            uniforms_[i].offset = arena_size;
+            arena_size += (uniforms_[i].bytes + 15) & ~(size_t)15;
+            if(sampler_target(uniforms_[i].type)) samplers_.push_back(i);
+        }
+        uniform_shadow_ = arena_size;
+        uniform_data_.assign(arena_size * 2, 0);
+        uniform_dirty_.assign((uniforms_.size() + 63) / 64, 0);
+
+        // Setup uniform blocks with the layout of their members.
+        const GLint block_count = getInfo<GL_ACTIVE_UNIFORM_BLOCKS>();
+        blocks_.clear();
+        blocks_.resize(block_count);
+        for(int i = 0; i < block_count; ++i) {
+            BlockLayout& block = blocks_[i];
+            GLint value;
+            __GLW_HANDLE(glGetActiveUniformBlockName(*this, i, name.size(), &length, &name[0])) {
+                return handle_error(__GLW_LAST_ERROR, "glGetActiveUniformBlockName");
+            }
+            block.name.assign(&name[0], length);
+            block.index = i;
+            __GLW_HANDLE(glGetActiveUniformBlockiv(*this, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.size)) {
+                return handle_error(__GLW_LAST_ERROR, "glGetActiveUniformBlockiv");
+            }
+            glGetActiveUniformBlockiv(*this, i, GL_UNIFORM_BLOCK_BINDING, &value);
+            block.binding = value;
+            glGetActiveUniformBlockiv(*this, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &value);
+            if(value == 0) continue;
+
+            std::vector<GLint> indices(value);
+            std::vector<GLint> offsets(value);
+            std::vector<GLint> sizes(value);
+            std::vector<GLint> types(value);
+            std::vector<GLint> array_strides(value);
+            std::vector<GLint> matrix_strides(value);
+            std::vector<GLint> row_majors(value);
+            glGetActiveUniformBlockiv(*this, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, &indices[0]);
+            const GLuint* members = (const GLuint*)&indices[0];
+            glGetActiveUniformsiv(*this, value, members, GL_UNIFORM_OFFSET, &offsets[0]);
+            glGetActiveUniformsiv(*this, value, members, GL_UNIFORM_SIZE, &sizes[0]);
+            glGetActiveUniformsiv(*this, value, members, GL_UNIFORM_TYPE, &types[0]);
+            glGetActiveUniformsiv(*this, value, members, GL_UNIFORM_ARRAY_STRIDE, &array_strides[0]);
+            glGetActiveUniformsiv(*this, value, members, GL_UNIFORM_IS_ROW_MAJOR, &row_majors[0]);
+            __GLW_HANDLE(glGetActiveUniformsiv(*this, value, members, GL_UNIFORM_MATRIX_STRIDE, &matrix_strides[0])) {
+                return handle_error(__GLW_LAST_ERROR, "glGetActiveUniformsiv");
+            }
+
+            block.members.resize(value);
+            for(int j = 0; j < value; ++j) {
+                BlockMember& member = block.members[j];
+                glGetActiveUniformName(*this, members[j], name.size(), &length, &name[0]);
+                member.name.assign(&name[0], length);
+                member.offset = offsets[j];
+                member.size = sizes[j];
+                member.type = types[j];
+                member.array_stride = array_strides[j];
+                member.matrix_stride = matrix_strides[j];
+                member.row_major = row_majors[j] != 0;
+            }
         }
 
         return GL_NO_ERROR;
     }
 
-    GLuint prepare()
+    // A format with 0 components uses the one of the shader type.
+    void assignAttribute(
+        Attribute& attribute__,
+        const GLuint buffer__,
+        const size_t stride__,
+        const VertexFormat& format__,
+        const GLuint divisor__)
+    {
+        if(attribute__.buffer == buffer__
+            && attribute__.offset == format__.offset
+            && attribute__.stride == stride__
+            && attribute__.divisor == divisor__
+            && attribute__.components == format__.components
+            && attribute__.component_type == format__.type
+            && attribute__.normalized == format__.normalized) {
+            return;
+        }
+        attribute__.buffer = buffer__;
+        attribute__.offset = format__.offset;
+        attribute__.stride = stride__;
+        attribute__.divisor = divisor__;
+        attribute__.components = format__.components;
+        attribute__.component_type = format__.type;
+        attribute__.normalized = format__.normalized;
+        vertex_array_dirty_ = true;
+    }
+
+    // Makes the program current and prepared for a draw, with the given
+    // element buffer bound unless it is 0.
+    GLuint begin(const GLuint element_buffer__)
     {
-        if(prepareAttributes() != GL_NO_ERROR) {
-            return handle_error(__GLW_LAST_ERROR, "Program::prepare");
+        GLuint error;
+        if((error = StateCache::current().useProgram<ErrorPolicy>(handle_)) != GL_NO_ERROR) {
+            return error;
         }
-        if(prepareUniforms() != GL_NO_ERROR) {
-            return handle_error(__GLW_LAST_ERROR, "Program::prepare");
+        if((error = prepare()) != GL_NO_ERROR) {
+            return error;
+        }
+        if(element_buffer__) {
+            return StateCache::current().bindBuffer<ErrorPolicy>(GL_ELEMENT_ARRAY_BUFFER, element_buffer__);
         }
         return GL_NO_ERROR;
     }
 
+public:
+    // Errors are reported by the step that failed, and returned as is.
+    GLuint prepare()
+    {
+        GLuint error;
+        if((error = prepareAttributes()) != GL_NO_ERROR) {
+            return error;
+        }
+        return prepareUniforms();
+    }
+
     GLuint execute(
         const GLenum topology__, 
         const GLint offset__, 
         const GLint elements__)
     {
-        __GLW_HANDLE(glUseProgram(*this)) {
-            return handle_error(__GLW_LAST_ERROR, "glUseProgram");
-        }
-        if(prepare() != GL_NO_ERROR) {
-            return handle_error(__GLW_LAST_ERROR, "Program::execute");
+        __GLW_PROFILE("Program::execute");
+        GLuint error;
+        if((error = begin(0)) != GL_NO_ERROR) {
+            return error;
         }
         __GLW_HANDLE(glDrawArrays(topology__, offset__, elements__)) {
             return handle_error(__GLW_LAST_ERROR, "glDrawArrays");
@@ -288,31 +867,161 @@ public:
         return GL_NO_ERROR;
     }
 
+    // Draws elements__ indices starting at index first__, each offset by
+    // base_vertex__, e.g. one mesh of a BufferPool.
     GLuint execute(
         const GLenum topology__, 
         const GLint elements__,
         const GLenum element_type__,
-        const GLuint element_buffer__)
+        const GLuint element_buffer__,
+        const GLint first__ = 0,
+        const GLint base_vertex__ = 0)
     {
-        __GLW_HANDLE(glUseProgram(*this)) {
-            return handle_error(__GLW_LAST_ERROR, "glUseProgram");
-        }
-        if(prepare() != GL_NO_ERROR) {
-            return handle_error(__GLW_LAST_ERROR, "Program::execute");
+        __GLW_PROFILE("Program::execute");
+        GLuint error;
+        if((error = begin(element_buffer__)) != GL_NO_ERROR) {
+            return error;
         }
-        __GLW_HANDLE(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer__)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindBuffer");
+        const void* indices = (const void*)(first__ * sizeof_type(element_type__));
+        if(base_vertex__) {
+            __GLW_HANDLE(glDrawElementsBaseVertex(
+                topology__,
+                elements__,
+                element_type__,
+                indices,
+                base_vertex__)) {
+                return handle_error(__GLW_LAST_ERROR, "glDrawElementsBaseVertex");
+            }
+            return GL_NO_ERROR;
         }
         __GLW_HANDLE(glDrawElements(
             topology__,
             elements__,
             element_type__,
-            0)) {
+            indices)) {
             return handle_error(__GLW_LAST_ERROR, "glDrawElements");
         }
         return GL_NO_ERROR;
     }
 
+    GLuint executeInstanced(
+        const GLenum topology__,
+        const GLint offset__,
+        const GLint elements__,
+        const GLsizei instances__)
+    {
+        __GLW_PROFILE("Program::executeInstanced");
+        GLuint error;
+        if((error = begin(0)) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glDrawArraysInstanced(topology__, offset__, elements__, instances__)) {
+            return handle_error(__GLW_LAST_ERROR, "glDrawArraysInstanced");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Draws elements__ indices starting at index first__, each offset by
+    // base_vertex__, instances__ times.
+    GLuint executeInstanced(
+        const GLenum topology__,
+        const GLint elements__,
+        const GLenum element_type__,
+        const GLuint element_buffer__,
+        const GLsizei instances__,
+        const GLint first__ = 0,
+        const GLint base_vertex__ = 0)
+    {
+        __GLW_PROFILE("Program::executeInstanced");
+        GLuint error;
+        if((error = begin(element_buffer__)) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glDrawElementsInstancedBaseVertex(
+            topology__,
+            elements__,
+            element_type__,
+            (const void*)(first__ * sizeof_type(element_type__)),
+            instances__,
+            base_vertex__)) {
+            return handle_error(__GLW_LAST_ERROR, "glDrawElementsInstancedBaseVertex");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Issues draws__ draws of elements__[i] vertices from offsets__[i] in
+    // a single call.
+    GLuint executeMulti(
+        const GLenum topology__,
+        const GLint* offsets__,
+        const GLsizei* elements__,
+        const GLsizei draws__)
+    {
+        __GLW_PROFILE("Program::executeMulti");
+        GLuint error;
+        if((error = begin(0)) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glMultiDrawArrays(topology__, offsets__, elements__, draws__)) {
+            return handle_error(__GLW_LAST_ERROR, "glMultiDrawArrays");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Issues draws__ draws of elements__[i] indices at byte offsets__[i]
+    // into the element buffer in a single call.
+    GLuint executeMulti(
+        const GLenum topology__,
+        const GLsizei* elements__,
+        const GLenum element_type__,
+        const GLuint element_buffer__,
+        const void* const* offsets__,
+        const GLsizei draws__)
+    {
+        __GLW_PROFILE("Program::executeMulti");
+        GLuint error;
+        if((error = begin(element_buffer__)) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glMultiDrawElements(topology__, elements__, element_type__, offsets__, draws__)) {
+            return handle_error(__GLW_LAST_ERROR, "glMultiDrawElements");
+        }
+        return GL_NO_ERROR;
+    }
+
+    // Issues draws__ indexed draws whose parameters are read by the GPU
+    // from indirect_buffer__, laid out as DrawElementsIndirectCommand
+    // structures stride__ bytes apart (0 for tightly packed) starting at
+    // offset__. Several draws require GL 4.3 or ARB_multi_draw_indirect.
+    GLuint executeIndirect(
+        const GLenum topology__,
+        const GLenum element_type__,
+        const GLuint element_buffer__,
+        const GLuint indirect_buffer__,
+        const GLintptr offset__ = 0,
+        const GLsizei draws__ = 1,
+        const GLsizei stride__ = 0)
+    {
+        __GLW_PROFILE("Program::executeIndirect");
+        GLuint error;
+        if((error = begin(element_buffer__)) != GL_NO_ERROR) {
+            return error;
+        }
+        if((error = StateCache::current().bindBuffer<ErrorPolicy>(GL_DRAW_INDIRECT_BUFFER, indirect_buffer__)) != GL_NO_ERROR) {
+            return error;
+        }
+        if(draws__ == 1) {
+            __GLW_HANDLE(glDrawElementsIndirect(topology__, element_type__, (const void*)offset__)) {
+                return handle_error(__GLW_LAST_ERROR, "glDrawElementsIndirect");
+            }
+            return GL_NO_ERROR;
+        }
+        __GLW_HANDLE(glMultiDrawElementsIndirect(topology__, element_type__, (const void*)offset__, draws__, stride__)) {
+            return handle_error(__GLW_LAST_ERROR, "glMultiDrawElementsIndirect");
+        }
+        return GL_NO_ERROR;
+    }
+
     std::string log()
     {
         std::string result;
@@ -325,51 +1034,164 @@ public:
         return result;
     }
 
+    AttributeHandle attributeHandle(const GLchar* name__) const
+    {
+        AttributeHandle handle = { findName(attributes_, attribute_names_, name__) };
+        return handle;
+    }
+
+    UniformHandle uniformHandle(const GLchar* name__) const
+    {
+        UniformHandle handle = { findName(uniforms_, uniform_names_, name__) };
+        return handle;
+    }
+
     GLuint setAttribute(
         const GLchar* name__,
         const GLuint buffer__,
         const size_t stride__ = 0,
-        const size_t offset__ = 0)
+        const size_t offset__ = 0,
+        const GLuint divisor__ = 0)
     {
-        Attribute* attribute = NULL;
-        for(int i = 0; i < attributes_.size(); ++i) {
-            if(strcmp(attributes_[i].name, name__) == 0) {
-                attribute = &attributes_[i];
-                break;
-            }
+        return setAttribute(attributeHandle(name__), buffer__, stride__, offset__, divisor__);
+    }
+
+    GLuint setAttribute(
+        const AttributeHandle handle__,
+        const GLuint buffer__,
+        const size_t stride__ = 0,
+        const size_t offset__ = 0,
+        const GLuint divisor__ = 0)
+    {
+        __GLW_PROFILE("Program::setAttribute");
+        if(!handle__.valid() || handle__.index >= (GLint)attributes_.size()) {
+            return handle_error(GL_INVALID_VALUE, "Program::setAttribute");
         }
-        if(!attribute) {
+        VertexFormat format = { 0, 0, offset__, GL_FALSE };
+        assignAttribute(attributes_[handle__.index], buffer__, stride__, format, divisor__);
+        return GL_NO_ERROR;
+    }
+
+    // Binds an attribute stored in the given format rather than the one of
+    // its shader type, e.g. GL_HALF_FLOAT, normalized GL_SHORT or
+    // GL_INT_2_10_10_10_REV (see glw_vertex_pack.hpp).
+    GLuint setAttribute(
+        const GLchar* name__,
+        const GLuint buffer__,
+        const size_t stride__,
+        const VertexFormat& format__,
+        const GLuint divisor__ = 0)
+    {
+        return setAttribute(attributeHandle(name__), buffer__, stride__, format__, divisor__);
+    }
+
+    GLuint setAttribute(
+        const AttributeHandle handle__,
+        const GLuint buffer__,
+        const size_t stride__,
+        const VertexFormat& format__,
+        const GLuint divisor__ = 0)
+    {
+        __GLW_PROFILE("Program::setAttribute");
+        if(!handle__.valid() || handle__.index >= (GLint)attributes_.size()) {
             return handle_error(GL_INVALID_VALUE, "Program::setAttribute");
         }
-        attribute->buffer = buffer__;
-        attribute->offset = offset__;
-        attribute->stride = stride__;
-        attribute->dirty = true;
+        if(format__.components < 1 || format__.components > 4) {
+            return handle_error(GL_INVALID_VALUE, "Program::setAttribute");
+        }
+        assignAttribute(attributes_[handle__.index], buffer__, stride__, format__, divisor__);
+        return GL_NO_ERROR;
+    }
+
+    // Binds every field of an interleaved VertexLayout from one buffer,
+    // the field i to the attribute names__[i]. Fields the program does not
+    // use are skipped.
+    template <typename Layout>
+    GLuint setAttributes(
+        const GLchar* const* names__,
+        const GLuint buffer__,
+        const size_t offset__ = 0,
+        const GLuint divisor__ = 0)
+    {
+        AttributeHandle handles[Layout::fields];
+        for(size_t i = 0; i < Layout::fields; ++i) {
+            handles[i] = attributeHandle(names__[i]);
+        }
+        return setAttributes<Layout>(handles, buffer__, offset__, divisor__);
+    }
+
+    template <typename Layout>
+    GLuint setAttributes(
+        const AttributeHandle* handles__,
+        const GLuint buffer__,
+        const size_t offset__ = 0,
+        const GLuint divisor__ = 0)
+    {
+        const VertexFormat* formats = Layout::formats();
+        for(size_t i = 0; i < Layout::fields; ++i) {
+            if(!handles__[i].valid() || handles__[i].index >= (GLint)attributes_.size()) continue;
+            VertexFormat format = formats[i];
+            format.offset += offset__;
+            assignAttribute(attributes_[handles__[i].index], buffer__, Layout::stride, format, divisor__);
+        }
         return GL_NO_ERROR;
     }
 
+    // Deletes the cached vertex array objects. This is done on the next
+    // draw after a wrapped buffer is deleted, since cached objects keep
+    // referring to buffers by name; call it after deleting one that was
+    // passed to setAttribute with glDeleteBuffers.
+    void clearVertexArrays()
+    {
+        typename VertexArrays::iterator it;
+        for(it = vertex_arrays_.begin(); it != vertex_arrays_.end(); ++it) {
+            StateCache::current().forgetVertexArray(it->second.name);
+            glDeleteVertexArrays(1, &it->second.name);
+        }
+        vertex_arrays_.clear();
+        vertex_array_ = 0;
+        vertex_array_dirty_ = true;
+    }
+
+    // Vertex array objects kept per program. Bindings that change every
+    // draw, e.g. the offset of streamed data, would otherwise create one
+    // for every value; the least recently used is deleted instead.
+    static const size_t max_vertex_arrays = 16;
+
+    size_t vertexArrays() const { return vertex_arrays_.size(); }
+
     template <typename T>
     GLuint setUniform(
         const GLchar* name__,
         const T& value__,
         const GLuint count__ = 1)
     {
-        Uniform* uniform = NULL;
-        for(int i = 0; i < uniforms_.size(); ++i) {
-            if(strcmp(uniforms_[i].name, name__) == 0) {
-                uniform = &uniforms_[i];
-                break;
-            }
-        }
-        if(!uniform) {
+        return setUniform(uniformHandle(name__), value__, count__);
+    }
+
+    template <typename T>
+    GLuint setUniform(
+        const UniformHandle handle__,
+        const T& value__,
+        const GLuint count__ = 1)
+    {
+        __GLW_PROFILE("Program::setUniform");
+        if(!handle__.valid() || handle__.index >= (GLint)uniforms_.size()) {
             return handle_error(GL_INVALID_VALUE, "Program::setUniform");
         }
+        Uniform* uniform = &uniforms_[handle__.index];
         const size_t size = sizeof(T) * count__;
         if(size > sizeof_type(uniform->type) * uniform->size) {
             return handle_error(GL_INVALID_VALUE, "Program::setUniform");
         }
-        memcpy(&uniform->data[0], &value__, size);
-        uniform->dirty = true;
+        GLubyte* data = &uniform_data_[uniform->offset];
+        const bool dirty = isDirty(handle__.index);
+        if(memcmp(data, &value__, size) == 0 && (dirty || uniform->uploaded)) {
+            if(!dirty) ++uniform_stats_.skipped;
+            return GL_NO_ERROR;
+        }
+        memcpy(data, &value__, size);
+        setDirty(handle__.index);
         return GL_NO_ERROR;
     }
 
@@ -378,23 +1200,32 @@ public:
         GLint unit__,
         GLuint texture__) 
     {
-        Uniform* uniform = NULL;
-        for(int i = 0; i < uniforms_.size(); ++i) {
-            if(strcmp(uniforms_[i].name, name__) == 0) {
-                uniform = &uniforms_[i];
-                break;
-            }
-        }
-        if(!uniform) {
+        return setSampler(uniformHandle(name__), unit__, texture__);
+    }
+
+    GLuint setSampler(
+        const UniformHandle handle__,
+        GLint unit__,
+        GLuint texture__) 
+    {
+        __GLW_PROFILE("Program::setSampler");
+        if(!handle__.valid() || handle__.index >= (GLint)uniforms_.size()) {
             return handle_error(GL_INVALID_VALUE, "Program::setSampler");
         }
+        Uniform* uniform = &uniforms_[handle__.index];
         const size_t size = sizeof(GLint);
         if(size > sizeof_type(uniform->type) * uniform->size) {
             return handle_error(GL_INVALID_VALUE, "Program::setSampler");
         }
         uniform->texture = texture__;
-        memcpy(&uniform->data[0], &unit__, size);
-        uniform->dirty = true;
+        GLubyte* data = &uniform_data_[uniform->offset];
+        const bool dirty = isDirty(handle__.index);
+        if(memcmp(data, &unit__, size) == 0 && (dirty || uniform->uploaded)) {
+            if(!dirty) ++uniform_stats_.skipped;
+            return GL_NO_ERROR;
+        }
+        memcpy(data, &unit__, size);
+        setDirty(handle__.index);
         return GL_NO_ERROR;
     }
 
@@ -410,8 +1241,82 @@ public:
 
     const Attributes& attributes() const { return attributes_; }
     const Uniforms& uniforms() const { return uniforms_; }
+
+    // Current value of a uniform in the program's uniform arena.
+    const void* uniformData(const Uniform& uniform__) const { return &uniform_data_[uniform__.offset]; }
+    const Blocks& blocks() const { return blocks_; }
+
+    const BlockLayout* block(const GLchar* name__) const
+    {
+        for(size_t i = 0; i < blocks_.size(); ++i) {
+            if(blocks_[i].name == name__) return &blocks_[i];
+        }
+        return NULL;
+    }
+
+    // Sources the named block from the given binding point. Programs sharing
+    // a binding point share the UniformBlock bound there.
+    GLuint bindBlock(const GLchar* name__, const GLuint binding__)
+    {
+        for(size_t i = 0; i < blocks_.size(); ++i) {
+            if(blocks_[i].name != name__) continue;
+            if(blocks_[i].binding == binding__) {
+                return GL_NO_ERROR;
+            }
+            __GLW_HANDLE(glUniformBlockBinding(*this, blocks_[i].index, binding__)) {
+                return handle_error(__GLW_LAST_ERROR, "glUniformBlockBinding");
+            }
+            blocks_[i].binding = binding__;
+            return GL_NO_ERROR;
+        }
+        return handle_error(GL_INVALID_VALUE, "Program::bindBlock");
+    }
+
+    // Counts glUniform* uploads issued by execute() and uploads avoided
+    // because the value matched what GL already holds.
+    const UniformStats& uniformStats() const { return uniform_stats_; }
+
+    void resetUniformStats()
+    {
+        uniform_stats_.uploads = 0;
+        uniform_stats_.skipped = 0;
+    }
 };
 
+typedef BasicProgram<> Program;
+
+// Hints how many threads the driver may use for compiling and linking in
+// the background; 0 disables them and 0xFFFFFFFF lets the driver choose.
+// Does nothing without KHR_parallel_shader_compile.
+static inline void set_compiler_threads(const GLuint count)
+{
+    if(has_extension("GL_KHR_parallel_shader_compile")) {
+        glMaxShaderCompilerThreadsKHR(count);
+    } else if(has_extension("GL_ARB_parallel_shader_compile")) {
+        glMaxShaderCompilerThreadsARB(count);
+    }
+}
+
+// Submits every program before checking any of them. Returns the first
+// error, after all programs have been finished.
+template <class ErrorPolicy>
+GLuint build_programs(BasicProgram<ErrorPolicy>* const* programs, const size_t count)
+{
+    GLuint result = GL_NO_ERROR;
+    std::vector<bool> submitted(count, false);
+    for(size_t i = 0; i < count; ++i) {
+        const GLuint error = programs[i]->submit();
+        submitted[i] = error == GL_NO_ERROR;
+        if(result == GL_NO_ERROR) result = error;
+    }
+    for(size_t i = 0; i < count; ++i) {
+        if(!submitted[i]) continue;
+        const GLuint error = programs[i]->finish();
+        if(result == GL_NO_ERROR) result = error;
+    }
+    return result;
+}
+
 } // namespace
 
 #endif
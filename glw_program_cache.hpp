@@ -0,0 +1,235 @@
+
+#ifndef __GLW_PROGRAM_CACHE_HPP
+#define __GLW_PROGRAM_CACHE_HPP
+
+#include "glw_program.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+namespace glw {
+
+// Stores linked program binaries in a directory, keyed by a hash of the
+// shader sources and the GL vendor, renderer and version strings, so a
+// driver update never picks up a stale binary. build() restores programs
+// from the cache with glProgramBinary and falls back to compiling when
+// there is no entry or the driver rejects it.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicProgramCache
+{
+public:
+    struct Stats
+    {
+        size_t hits;
+        size_t misses;
+        size_t rejected;
+    };
+
+private:
+    struct Header
+    {
+        GLuint magic;
+        GLenum format;
+        GLuint64 key;
+    };
+
+    static const GLuint magic = 0x42574c47; // "GLWB"
+
+    std::string directory_;
+    std::string driver_;
+    Stats stats_;
+
+    BasicProgramCache(const BasicProgramCache&);
+
+    static GLuint64 hash(GLuint64 hash__, const void* data__, size_t size__)
+    {
+        // FNV-1a.
+        const GLubyte* data = (const GLubyte*)data__;
+        for(size_t i = 0; i < size__; ++i) {
+            hash__ ^= data[i];
+            hash__ *= 1099511628211ull;
+        }
+        return hash__;
+    }
+
+    static std::string getString(const GLenum name__)
+    {
+        const GLubyte* value = glGetString(name__);
+        return value ? std::string((const char*)value) : std::string();
+    }
+
+    std::string path(const GLuint64 key__) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key__);
+        return directory_ + "/" + name;
+    }
+
+    // Sets found__ if there is a valid entry, whether or not the driver
+    // accepts it.
+    GLuint load(BasicProgram<ErrorPolicy>& program__, const GLuint64 key__, bool& found__)
+    {
+        const std::string file = path(key__);
+        GLuint result = GL_INVALID_OPERATION;
+        found__ = false;
+#ifndef _WIN32
+        // Map the file rather than reading it; binaries can be large.
+        const int fd = open(file.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return result;
+        }
+        struct stat info;
+        if(fstat(fd, &info) == 0 && (size_t)info.st_size > sizeof(Header)) {
+            void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED) {
+                const Header* header = (const Header*)data;
+                if(header->magic == magic && header->key == key__) {
+                    found__ = true;
+                    result = program__.loadBinary(
+                        header->format,
+                        header + 1,
+                        info.st_size - sizeof(Header));
+                }
+                munmap(data, info.st_size);
+            }
+        }
+        close(fd);
+#else
+        FILE* stream = fopen(file.c_str(), "rb");
+        if(!stream) {
+            return result;
+        }
+        Header header;
+        std::vector<GLubyte> data;
+        if(fread(&header, sizeof(header), 1, stream) == 1
+            && header.magic == magic
+            && header.key == key__) {
+            GLubyte chunk[4096];
+            size_t count;
+            while((count = fread(chunk, 1, sizeof(chunk), stream)) > 0) {
+                data.insert(data.end(), chunk, chunk + count);
+            }
+            if(!data.empty()) {
+                found__ = true;
+                result = program__.loadBinary(header.format, &data[0], data.size());
+            }
+        }
+        fclose(stream);
+#endif
+        return result;
+    }
+
+    GLuint store(BasicProgram<ErrorPolicy>& program__, const GLuint64 key__)
+    {
+        Header header = { magic, 0, key__ };
+        std::vector<GLubyte> data;
+        GLuint error;
+        if((error = program__.getBinary(header.format, data)) != GL_NO_ERROR) {
+            return error;
+        }
+
+        // Write to a temporary file of this process and call first so that
+        // concurrent processes never see a partial entry, nor write into
+        // each other's.
+        static std::atomic<unsigned> sequence(0);
+        char suffix[48];
+#ifndef _WIN32
+        const long process = (long)getpid();
+#else
+        const long process = (long)_getpid();
+#endif
+        snprintf(suffix, sizeof(suffix), ".%ld.%u.tmp", process, sequence++);
+        const std::string file = path(key__);
+        const std::string temporary = file + suffix;
+        FILE* stream = fopen(temporary.c_str(), "wb");
+        if(!stream) {
+            return handle_error(GL_INVALID_OPERATION, "ProgramCache::store");
+        }
+        const bool written =
+            fwrite(&header, sizeof(header), 1, stream) == 1 &&
+            fwrite(&data[0], data.size(), 1, stream) == 1;
+        if(fclose(stream) != 0 || !written) {
+            remove(temporary.c_str());
+            return handle_error(GL_INVALID_OPERATION, "ProgramCache::store");
+        }
+#ifdef _WIN32
+        remove(file.c_str());
+#endif
+        if(rename(temporary.c_str(), file.c_str()) != 0) {
+            remove(temporary.c_str());
+            return handle_error(GL_INVALID_OPERATION, "ProgramCache::store");
+        }
+        return GL_NO_ERROR;
+    }
+
+public:
+    // The directory must exist. Requires a current context.
+    BasicProgramCache(const std::string& directory__)
+      : directory_(directory__)
+    {
+        driver_ = getString(GL_VENDOR) + '\n' + getString(GL_RENDERER) + '\n' + getString(GL_VERSION);
+        resetStats();
+    }
+
+    GLuint64 key(const BasicProgram<ErrorPolicy>& program__) const
+    {
+        GLuint64 result = hash(14695981039346656037ull, driver_.c_str(), driver_.size() + 1);
+        const typename BasicProgram<ErrorPolicy>::Shaders& sources = program__.sources();
+        for(size_t i = 0; i < sources.size(); ++i) {
+            result = hash(result, &sources[i].type, sizeof(sources[i].type));
+            result = hash(result, sources[i].source, strlen(sources[i].source) + 1);
+        }
+        return result;
+    }
+
+    // Restores the program from the cache, or builds it from source and
+    // adds it to the cache.
+    GLuint build(BasicProgram<ErrorPolicy>& program__)
+    {
+        const GLuint64 program_key = key(program__);
+        bool found;
+        if(load(program__, program_key, found) == GL_NO_ERROR) {
+            ++stats_.hits;
+            return GL_NO_ERROR;
+        }
+        ++stats_.misses;
+        if(found) {
+            ++stats_.rejected;
+        }
+
+        GLuint error;
+        program__.setBinaryRetrievable(true);
+        if((error = program__.build()) != GL_NO_ERROR) {
+            return error;
+        }
+        // A failed store only costs a compile on the next run.
+        store(program__, program_key);
+        return GL_NO_ERROR;
+    }
+
+    const std::string& directory() const { return directory_; }
+    const Stats& stats() const { return stats_; }
+
+    void resetStats()
+    {
+        stats_.hits = 0;
+        stats_.misses = 0;
+        stats_.rejected = 0;
+    }
+};
+
+typedef BasicProgramCache<> ProgramCache;
+
+} // namespace
+
+#endif
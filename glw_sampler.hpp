@@ -3,10 +3,16 @@
 
 #include "glw.hpp"
 
-class Sampler : public Wrapper
+namespace glw {
+
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicSampler : public Wrapper
 {
+private:
+    static const GLuint debug_source = SOURCE_SAMPLER;
+
 public:
-    Sampler(
+    BasicSampler(
         const GLenum min_filter__,
         const GLenum mag_filter__,
         const GLenum wrap__,
@@ -15,27 +21,39 @@ public:
         __GLW_HANDLE(glGenSamplers(1, &handle_)) {}
 
         __GLW_HANDLE(glSamplerParameteri(*this, GL_TEXTURE_MIN_FILTER, min_filter__)) {
-            if(error) *error = handleError(__GLW_LAST_ERROR, "glSamplerParameteri");
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glSamplerParameteri");
         }
         __GLW_HANDLE(glSamplerParameteri(*this, GL_TEXTURE_MAG_FILTER, mag_filter__)) {
-            if(error) *error = handleError(__GLW_LAST_ERROR, "glSamplerParameteri");
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glSamplerParameteri");
         }
         __GLW_HANDLE(glSamplerParameteri(*this, GL_TEXTURE_WRAP_S, wrap__)) {
-            if(error) *error = handleError(__GLW_LAST_ERROR, "glSamplerParameteri");
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glSamplerParameteri");
         }
         __GLW_HANDLE(glSamplerParameteri(*this, GL_TEXTURE_WRAP_T, wrap__)) {
-            if(error) *error = handleError(__GLW_LAST_ERROR, "glSamplerParameteri");
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glSamplerParameteri");
         }
         __GLW_HANDLE(glSamplerParameteri(*this, GL_TEXTURE_WRAP_R, wrap__)) {
-            if(error) *error = handleError(__GLW_LAST_ERROR, "glSamplerParameteri");
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glSamplerParameteri");
+        }
+    }
+
+    ~BasicSampler()
+    {
+        if(handle_) {
+            StateCache::current().forgetSampler(handle_);
+            glDeleteSamplers(1, &handle_);
         }
     }
 
-    ~Sampler()
+    GLuint bind(const GLuint unit__)
     {
-        if(handle_) glDeleteSamplers(1, &handle_);
+        return StateCache::current().bindSampler<ErrorPolicy>(unit__, handle_);
     }
 };
 
+typedef BasicSampler<> Sampler;
+
+} // namespace
+
 #endif
 
@@ -0,0 +1,173 @@
+
+#ifndef __GLW_STREAM_BUFFER_HPP
+#define __GLW_STREAM_BUFFER_HPP
+
+#include "glw_buffer.hpp"
+
+namespace glw {
+
+// Ring of per-frame regions for dynamic data written directly by the CPU.
+//
+// With ARB_buffer_storage the buffer stays persistently and coherently
+// mapped; allocate() only moves a cursor and advance() fences the frame's
+// region, waiting only if the GPU still reads the region it moves to.
+// Without it, allocate() maps each range unsynchronized and the buffer is
+// orphaned whenever it fills up; commit() must then be called before the
+// data is drawn.
+//
+// Allocate vertex data with the vertex stride as alignment and pass
+// offset / stride as the first vertex to execute(), so the attribute
+// binding (and thus the Program's cached vertex array) never changes.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicStreamBuffer
+{
+private:
+    static const GLuint debug_source = SOURCE_BUFFER;
+    static const GLbitfield persistent_flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    BasicBuffer<ErrorPolicy>* buffer_;
+    GLubyte* mapping_;
+    std::vector<GLsync> fences_;
+    size_t region_size_;
+    size_t region_;
+    size_t cursor_;
+    bool mapped_;
+
+    BasicStreamBuffer(const BasicStreamBuffer&);
+
+    GLuint wait(const size_t region__)
+    {
+        GLsync& fence = fences_[region__];
+        if(!fence) {
+            return GL_NO_ERROR;
+        }
+        GLenum status;
+        do {
+            __GLW_HANDLE(status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000)) {
+                return handle_error(__GLW_LAST_ERROR, "glClientWaitSync");
+            }
+        } while(status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(fence);
+        fence = 0;
+        if(status == GL_WAIT_FAILED) {
+            return handle_error(GL_INVALID_OPERATION, "glClientWaitSync");
+        }
+        return GL_NO_ERROR;
+    }
+
+public:
+    BasicStreamBuffer(
+        const GLenum target__,
+        const size_t region_size__,
+        const size_t frames__ = 3,
+        const bool persistent__ = true,
+        GLuint* error = NULL)
+      : buffer_(NULL),
+        mapping_(NULL),
+        fences_(frames__, (GLsync)0),
+        region_size_(region_size__),
+        region_(0),
+        cursor_(0),
+        mapped_(false)
+    {
+        GLuint result = GL_NO_ERROR;
+        const size_t size = region_size__ * frames__;
+        if(persistent__ && has_extension("GL_ARB_buffer_storage")) {
+            buffer_ = new BasicBuffer<ErrorPolicy>(target__, size, NULL, persistent_flags, &result);
+            if(result == GL_NO_ERROR) {
+                mapping_ = (GLubyte*)buffer_->map(0, size, persistent_flags, &result);
+            }
+        } else {
+            buffer_ = new BasicBuffer<ErrorPolicy>(target__, GL_STREAM_DRAW, size, NULL, &result);
+        }
+        if(error) *error = result;
+    }
+
+    ~BasicStreamBuffer()
+    {
+        if(mapped_) buffer_->unmap();
+        for(size_t i = 0; i < fences_.size(); ++i) {
+            if(fences_[i]) glDeleteSync(fences_[i]);
+        }
+        delete buffer_;
+    }
+
+    // Returns a pointer to size__ writable bytes and their offset__ in the
+    // buffer, a multiple of alignment__, or NULL if the frame's region is
+    // exhausted.
+    void* allocate(const size_t size__, GLintptr& offset__, const size_t alignment__ = 16)
+    {
+        size_t start = (cursor_ + alignment__ - 1) / alignment__ * alignment__;
+
+        if(mapping_) {
+            // Align the offset in the buffer, not in the region, which
+            // need not be a multiple of alignment__.
+            const size_t base = region_ * region_size_;
+            start = (base + cursor_ + alignment__ - 1) / alignment__ * alignment__ - base;
+            if(start + size__ > region_size_) {
+                handle_error(GL_OUT_OF_MEMORY, "StreamBuffer::allocate");
+                return NULL;
+            }
+            cursor_ = start + size__;
+            offset__ = base + start;
+            return mapping_ + offset__;
+        }
+
+        if(size__ > buffer_->size() || commit() != GL_NO_ERROR) {
+            handle_error(GL_OUT_OF_MEMORY, "StreamBuffer::allocate");
+            return NULL;
+        }
+        if(start + size__ > buffer_->size()) {
+            if(buffer_->orphan() != GL_NO_ERROR) return NULL;
+            start = 0;
+        }
+        void* mem = buffer_->map(
+            start,
+            size__,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if(!mem) return NULL;
+        mapped_ = true;
+        cursor_ = start + size__;
+        offset__ = start;
+        return mem;
+    }
+
+    // Makes the last allocation visible to GL. Only needed without
+    // persistent mapping.
+    GLuint commit()
+    {
+        if(!mapped_) {
+            return GL_NO_ERROR;
+        }
+        mapped_ = false;
+        return buffer_->unmap();
+    }
+
+    // Ends the frame: fences the current region and moves on to the next
+    // one, waiting until the GPU has finished reading it.
+    GLuint advance()
+    {
+        if(!mapping_) {
+            return commit();
+        }
+        __GLW_HANDLE(fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)) {
+            return handle_error(__GLW_LAST_ERROR, "glFenceSync");
+        }
+        region_ = (region_ + 1) % fences_.size();
+        cursor_ = 0;
+        return wait(region_);
+    }
+
+    BasicBuffer<ErrorPolicy>& buffer() { return *buffer_; }
+    GLuint id() const { return buffer_->id(); }
+    bool persistent() const { return mapping_ != NULL; }
+    size_t regionSize() const { return region_size_; }
+    size_t frames() const { return fences_.size(); }
+};
+
+typedef BasicStreamBuffer<> StreamBuffer;
+
+} // namespace
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "glw.hpp"
 
+#include <algorithm>
+
 namespace glw {
 
 struct ImageFormat
@@ -11,35 +13,201 @@ struct ImageFormat
     GLenum order;
 };
 
-class Texture : public Wrapper
+static inline size_t sizeof_pixel(const ImageFormat& format)
+{
+    size_t components;
+    switch(format.order) {
+    case GL_RG:
+    case GL_RG_INTEGER:
+    case GL_DEPTH_STENCIL:      components = 2; break;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+    case GL_BGR_INTEGER:        components = 3; break;
+    case GL_RGBA:
+    case GL_BGRA:
+    case GL_RGBA_INTEGER:
+    case GL_BGRA_INTEGER:       components = 4; break;
+    default:                    components = 1; break;
+    }
+
+    switch(format.type) {
+    case GL_UNSIGNED_BYTE_3_3_2:
+    case GL_UNSIGNED_BYTE_2_3_3_REV:        return 1;
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_5_6_5_REV:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_1_5_5_5_REV:     return 2;
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_10_10_10_2:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:       return 4;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV: return 8;
+    case GL_HALF_FLOAT:                     return components * sizeof(GLhalf);
+    default:                                return components * sizeof_type(format.type);
+    }
+}
+
+// Bytes spanned by an image in client memory, with rows padded to
+// alignment (see GL_PACK_ALIGNMENT and GL_UNPACK_ALIGNMENT).
+static inline size_t sizeof_image(
+    const ImageFormat& format,
+    const GLint size_x,
+    const GLint size_y,
+    const GLint size_z = 1,
+    const GLint alignment = 4)
+{
+    const size_t line = size_x * sizeof_pixel(format);
+    const size_t row = (line + alignment - 1) / alignment * alignment;
+    return size_x && size_y && size_z ? row * (size_y * size_z - 1) + line : 0;
+}
+
+// Bytes per 4x4 block of a block-compressed internal format, or 0 if the
+// format is not one.
+static inline size_t sizeof_block(const GLenum internal_format)
+{
+    switch(internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_R11_EAC:
+    case GL_COMPRESSED_SIGNED_R11_EAC:                  return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case GL_COMPRESSED_RG11_EAC:
+    case GL_COMPRESSED_SIGNED_RG11_EAC:                 return 16;
+    default:                                            return 0;
+    }
+}
+
+// Bytes of a block-compressed image; partial blocks at the edges count as
+// whole blocks.
+static inline size_t sizeof_compressed_image(
+    const GLenum internal_format,
+    const GLint size_x,
+    const GLint size_y)
+{
+    return (size_t)((size_x + 3) / 4) * ((size_y + 3) / 4) * sizeof_block(internal_format);
+}
+
+// Whether the context can store a block-compressed internal format.
+static inline bool has_compressed_format(const GLenum internal_format)
+{
+    switch(internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return has_extension("GL_EXT_texture_compression_s3tc");
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        return has_extension("GL_EXT_texture_compression_s3tc")
+            && (has_extension("GL_EXT_texture_sRGB") || has_extension("GL_EXT_texture_compression_s3tc_srgb"));
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+        return has_version(3, 0) || has_extension("GL_ARB_texture_compression_rgtc");
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        return has_version(4, 2) || has_extension("GL_ARB_texture_compression_bptc");
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case GL_COMPRESSED_R11_EAC:
+    case GL_COMPRESSED_SIGNED_R11_EAC:
+    case GL_COMPRESSED_RG11_EAC:
+    case GL_COMPRESSED_SIGNED_RG11_EAC:
+        return has_version(4, 3) || has_extension("GL_ARB_ES3_compatibility");
+    default:
+        return false;
+    }
+}
+
+// Number of levels of a full mip chain, down to 1x1.
+static inline GLint mip_levels(const GLint size_x, const GLint size_y = 1, const GLint size_z = 1)
+{
+    GLint size = std::max(size_x, std::max(size_y, size_z));
+    GLint levels = 1;
+    while(size > 1) {
+        size >>= 1;
+        ++levels;
+    }
+    return levels;
+}
+
+static inline bool has_texture_storage()
+{
+    return StateCache::current().supports(StateCache::CAPABILITY_TEXTURE_STORAGE);
+}
+
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTexture : public Wrapper
 {
 protected:
+    static const GLuint debug_source = SOURCE_TEXTURE;
+
     GLenum target_;
     GLint format_;
     GLint size_x_;
     GLint size_y_;
     GLint size_z_;
+    GLint levels_;
 
-    Texture(
+    BasicTexture(
         const GLenum target__,
         const GLenum format__,
         const GLint size_x__, 
         const GLint size_y__,
         const GLint size_z__,
-        GLuint* error)
+        GLuint* error,
+        const GLint levels__ = 1)
       : target_(target__),
         format_(format__),
         size_x_(size_x__),
         size_y_(size_y__),
-        size_z_(size_z__)
+        size_z_(size_z__),
+        levels_(levels__)
     {
-
+        GLuint result;
         __GLW_HANDLE(glGenTextures(1, &handle_)) {}
-        __GLW_HANDLE(glBindTexture(target_, *this)) {
-            if(error) *error = handle_error(__GLW_LAST_ERROR, "glBindTexture");
+        if((result = bind()) != GL_NO_ERROR) {
+            if(error) *error = result;
             return;
         }
-        __GLW_HANDLE(glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, GL_NEAREST)) {
+        __GLW_HANDLE(glTexParameteri(
+            target_,
+            GL_TEXTURE_MIN_FILTER,
+            levels_ > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST)) {
             if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexParameteri");
             return;
         }
@@ -47,38 +215,153 @@ protected:
             if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexParameteri");
             return;
         }
-        __GLW_HANDLE(glGenerateMipmap(target_)) {
-            if(error) *error = handle_error(__GLW_LAST_ERROR, "glGenerateMipmap");
-        }
-#if 0
-        __GLW_HANDLE(glTexParameteri(target_, GL_GENERATE_MIPMAP, GL_TRUE)) {
+        // Levels are complete once the ones the texture has are defined.
+        __GLW_HANDLE(glTexParameteri(target_, GL_TEXTURE_MAX_LEVEL, levels_ - 1)) {
             if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexParameteri");
-            return;
         }
-#endif
     }
 
-    ~Texture()
+    ~BasicTexture()
+    {
+        if(handle_) {
+            StateCache::current().forgetTexture(handle_);
+            glDeleteTextures(1, &handle_);
+        }
+    }
+
+    // Whether reads go to a pixel pack buffer rather than client memory.
+    static bool packing()
+    {
+        GLuint buffer = StateCache::current().boundBuffer(GL_PIXEL_PACK_BUFFER);
+        if(buffer == StateCache::unknown) {
+            GLint bound = 0;
+            glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &bound);
+            buffer = bound;
+        }
+        return buffer != 0;
+    }
+
+    // Reads size_z__ images of a region, starting at image offset_z__: the
+    // slice of 3D textures, the layer of arrays or the face of cube maps.
+    // With a GL_PIXEL_PACK_BUFFER bound, data__ is an offset into that
+    // buffer.
+    GLuint readImage(
+        const GLint lod__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint offset_z__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        void* data__)
     {
-        if(handle_) glDeleteTextures(1, &handle_);
+        // Reads into a pack buffer are counted when that buffer is read.
+        __GLW_COUNT(bytes_read, packing() ? 0 : (GLuint64)sizeof_pixel(format__) * size_x__ * size_y__ * size_z__);
+        if(StateCache::current().supports(StateCache::CAPABILITY_GET_TEXTURE_SUB_IMAGE)) {
+            // The size only bounds what GL may write; the largest pack
+            // alignment saves querying the current one.
+            __GLW_HANDLE(glGetTextureSubImage(
+                handle_,
+                lod__,
+                offset_x__,
+                offset_y__,
+                offset_z__,
+                size_x__,
+                size_y__,
+                size_z__,
+                format__.order,
+                format__.type,
+                sizeof_image(format__, size_x__, size_y__, size_z__, 8),
+                data__)) {
+                return handle_error(__GLW_LAST_ERROR, "glGetTextureSubImage");
+            }
+            return GL_NO_ERROR;
+        }
+
+        // Fall back to reading one image at a time through a temporary
+        // framebuffer.
+        GLint alignment = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+        const size_t line = size_x__ * sizeof_pixel(format__);
+        const size_t image = (line + alignment - 1) / alignment * alignment * size_y__;
+        GLint previous = 0;
+        GLuint framebuffer = 0;
+        GLuint error = GL_NO_ERROR;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+        __GLW_HANDLE(glGenFramebuffers(1, &framebuffer)) {
+            return handle_error(__GLW_LAST_ERROR, "glGenFramebuffers");
+        }
+        __GLW_HANDLE(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer)) {
+            error = handle_error(__GLW_LAST_ERROR, "glBindFramebuffer");
+        }
+        for(GLint z = 0; z < size_z__ && error == GL_NO_ERROR; ++z) {
+            if(target_ == GL_TEXTURE_2D || target_ == GL_TEXTURE_CUBE_MAP) {
+                const GLenum image_target = target_ == GL_TEXTURE_2D
+                    ? GL_TEXTURE_2D
+                    : GL_TEXTURE_CUBE_MAP_POSITIVE_X + offset_z__ + z;
+                __GLW_HANDLE(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, image_target, handle_, lod__)) {
+                    error = handle_error(__GLW_LAST_ERROR, "glFramebufferTexture2D");
+                }
+            } else {
+                __GLW_HANDLE(glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, handle_, lod__, offset_z__ + z)) {
+                    error = handle_error(__GLW_LAST_ERROR, "glFramebufferTextureLayer");
+                }
+            }
+            if(error == GL_NO_ERROR) {
+                __GLW_HANDLE(glReadPixels(
+                    offset_x__,
+                    offset_y__,
+                    size_x__,
+                    size_y__,
+                    format__.order,
+                    format__.type,
+                    (GLubyte*)data__ + z * image)) {
+                    error = handle_error(__GLW_LAST_ERROR, "glReadPixels");
+                }
+            }
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+        glDeleteFramebuffers(1, &framebuffer);
+        return error;
     }
 
 public:
+    // Binds to the active texture unit.
     GLuint bind()
     {
-        __GLW_HANDLE(glBindTexture(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindTexture");
+        return StateCache::current().bindTexture<ErrorPolicy>(target_, handle_);
+    }
+
+    // Fills levels 1 and up from level 0. Textures of a single level, such
+    // as those with mutable storage, have none to fill.
+    GLuint generateMipmaps()
+    {
+        __GLW_PROFILE("Texture::generateMipmaps");
+        GLuint error;
+        if(levels_ <= 1) {
+            return handle_error(GL_INVALID_OPERATION, "Texture::generateMipmaps");
+        }
+        if((error = bind()) != GL_NO_ERROR) {
+            return error;
         }
+        __GLW_HANDLE(glGenerateMipmap(target_)) {
+            return handle_error(__GLW_LAST_ERROR, "glGenerateMipmap");
+        }
+        return GL_NO_ERROR;
     }
 
     template <GLenum Name>
     GLint getInfo(const GLint lod__) 
     {
+        GLuint error;
         GLint result;
-        __GLW_HANDLE(glBindTexture(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindTexture");
+        if((error = bind()) != GL_NO_ERROR) {
+            return error;
         }
-        __GLW_HANDLE(glGetTexLevelParameteriv(target_, lod__, Name, &result)) {
+        // Cube map levels are queried through one of their faces.
+        const GLenum target = target_ == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target_;
+        __GLW_HANDLE(glGetTexLevelParameteriv(target, lod__, Name, &result)) {
             return handle_error(__GLW_LAST_ERROR, "glGetTexLevelParameteriv");
         }
         return result;
@@ -89,19 +372,58 @@ public:
     GLint width() const { return size_x_; }
     GLint height() const { return size_y_; }
     GLint depth() const { return size_z_; }
+    GLint levels() const { return levels_; }
 };
 
-class Texture2D : public Texture
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTexture2D : public BasicTexture<ErrorPolicy>
 {
+protected:
+    using BasicTexture<ErrorPolicy>::target_;
+    using BasicTexture<ErrorPolicy>::size_x_;
+    using BasicTexture<ErrorPolicy>::size_y_;
+    using BasicTexture<ErrorPolicy>::levels_;
+
 public:
-    Texture2D(
+    // Immutable storage for levels__ levels (0 for a full mip chain) of a
+    // sized internal format such as GL_RGBA8. Write level 0 and call
+    // generateMipmaps(), or write every level.
+    BasicTexture2D(
+        const GLenum internal_format__,
+        const GLint levels__,
+        const GLint size_x__,
+        const GLint size_y__,
+        GLuint* error = NULL)
+      : BasicTexture<ErrorPolicy>(
+            GL_TEXTURE_2D,
+            internal_format__,
+            size_x__,
+            size_y__,
+            0,
+            error,
+            levels__ > 0 ? levels__ : mip_levels(size_x__, size_y__))
+    {
+        if(error && *error != GL_NO_ERROR) {
+            return;
+        }
+        if(!has_texture_storage()) {
+            if(error) *error = handle_error(GL_INVALID_OPERATION, "glTexStorage2D");
+            return;
+        }
+        __GLW_HANDLE(glTexStorage2D(target_, levels_, internal_format__, size_x_, size_y_)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexStorage2D");
+        }
+    }
+
+    // Mutable storage for level 0 only, optionally initialized with data__.
+    BasicTexture2D(
         const GLint internal_format__,
         const ImageFormat& format__,
         const GLint size_x__, 
         const GLint size_y__,
         const void* data__,
         GLuint* error = NULL)
-      : Texture(GL_TEXTURE_2D, internal_format__, size_x__, size_y__, 0, error)
+      : BasicTexture<ErrorPolicy>(GL_TEXTURE_2D, internal_format__, size_x__, size_y__, 0, error)
     {
         if(error && *error != GL_NO_ERROR) {
             return;
@@ -111,7 +433,7 @@ public:
             0, 
             internal_format__, 
             size_x_, 
-            size_y__,
+            size_y_,
             0, 
             format__.order, 
             format__.type, 
@@ -129,8 +451,10 @@ public:
         const GLint size_y__,
         const void* data__)
     {
-        __GLW_HANDLE(glBindTexture(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindTexture");
+        __GLW_PROFILE("Texture2D::write");
+        GLuint error;
+        if((error = this->bind()) != GL_NO_ERROR) {
+            return error;
         }
         __GLW_HANDLE(glTexSubImage2D(
             target_,
@@ -144,6 +468,199 @@ public:
             data__)) {
             return handle_error(__GLW_LAST_ERROR, "glTexSubImage2D");
         }
+        __GLW_COUNT(bytes_uploaded, (GLuint64)sizeof_pixel(format__) * size_x__ * size_y__);
+        return GL_NO_ERROR;
+    }
+
+    // Writes a region of a block-compressed level, in the internal format
+    // of the texture. Offsets and sizes are multiples of 4 except at the
+    // edges of the level; size__ is the byte size of data__.
+    GLuint writeCompressed(
+        const GLint lod__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLsizei size__,
+        const void* data__)
+    {
+        __GLW_PROFILE("Texture2D::writeCompressed");
+        GLuint error;
+        if((error = this->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glCompressedTexSubImage2D(
+            target_,
+            lod__,
+            offset_x__,
+            offset_y__,
+            size_x__,
+            size_y__,
+            this->format_,
+            size__,
+            data__)) {
+            return handle_error(__GLW_LAST_ERROR, "glCompressedTexSubImage2D");
+        }
+        __GLW_COUNT(bytes_uploaded, size__);
+        return GL_NO_ERROR;
+    }
+
+    // Reads the given region only. With a GL_PIXEL_PACK_BUFFER bound,
+    // data__ is an offset into that buffer.
+    GLuint read(
+        const GLint lod__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        void* data__)
+    {
+        __GLW_PROFILE("Texture2D::read");
+        return this->readImage(lod__, format__, offset_x__, offset_y__, 0, size_x__, size_y__, 1, data__);
+    }
+};
+
+// Storage and sub-region access shared by 2D array and 3D textures, whose
+// images are addressed by a third coordinate.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTexture3DBase : public BasicTexture<ErrorPolicy>
+{
+protected:
+    using BasicTexture<ErrorPolicy>::target_;
+    using BasicTexture<ErrorPolicy>::size_x_;
+    using BasicTexture<ErrorPolicy>::size_y_;
+    using BasicTexture<ErrorPolicy>::size_z_;
+    using BasicTexture<ErrorPolicy>::levels_;
+
+    // Immutable storage.
+    BasicTexture3DBase(
+        const GLenum target__,
+        const GLenum internal_format__,
+        const GLint levels__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        GLuint* error)
+      : BasicTexture<ErrorPolicy>(
+            target__,
+            internal_format__,
+            size_x__,
+            size_y__,
+            size_z__,
+            error,
+            levels__)
+    {
+        if(error && *error != GL_NO_ERROR) {
+            return;
+        }
+        if(!has_texture_storage()) {
+            if(error) *error = handle_error(GL_INVALID_OPERATION, "glTexStorage3D");
+            return;
+        }
+        __GLW_HANDLE(glTexStorage3D(target_, levels_, internal_format__, size_x_, size_y_, size_z_)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexStorage3D");
+        }
+    }
+
+    // Mutable storage for level 0 only.
+    BasicTexture3DBase(
+        const GLenum target__,
+        const GLint internal_format__,
+        const ImageFormat& format__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        const void* data__,
+        GLuint* error)
+      : BasicTexture<ErrorPolicy>(target__, internal_format__, size_x__, size_y__, size_z__, error)
+    {
+        if(error && *error != GL_NO_ERROR) {
+            return;
+        }
+        __GLW_HANDLE(glTexImage3D(
+            target_,
+            0,
+            internal_format__,
+            size_x_,
+            size_y_,
+            size_z_,
+            0,
+            format__.order,
+            format__.type,
+            data__)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexImage3D");
+        }
+    }
+
+public:
+    GLuint write(
+        const GLint lod__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint offset_z__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        const void* data__)
+    {
+        __GLW_PROFILE("Texture3D::write");
+        GLuint error;
+        if((error = this->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glTexSubImage3D(
+            target_,
+            lod__,
+            offset_x__,
+            offset_y__,
+            offset_z__,
+            size_x__,
+            size_y__,
+            size_z__,
+            format__.order,
+            format__.type,
+            data__)) {
+            return handle_error(__GLW_LAST_ERROR, "glTexSubImage3D");
+        }
+        __GLW_COUNT(bytes_uploaded, (GLuint64)sizeof_pixel(format__) * size_x__ * size_y__ * size_z__);
+        return GL_NO_ERROR;
+    }
+
+    // Writes a region of a block-compressed level, see
+    // BasicTexture2D::writeCompressed.
+    GLuint writeCompressed(
+        const GLint lod__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint offset_z__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        const GLsizei size__,
+        const void* data__)
+    {
+        __GLW_PROFILE("Texture3D::writeCompressed");
+        GLuint error;
+        if((error = this->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glCompressedTexSubImage3D(
+            target_,
+            lod__,
+            offset_x__,
+            offset_y__,
+            offset_z__,
+            size_x__,
+            size_y__,
+            size_z__,
+            this->format_,
+            size__,
+            data__)) {
+            return handle_error(__GLW_LAST_ERROR, "glCompressedTexSubImage3D");
+        }
+        __GLW_COUNT(bytes_uploaded, size__);
         return GL_NO_ERROR;
     }
 
@@ -152,20 +669,260 @@ public:
         const ImageFormat& format__,
         const GLint offset_x__,
         const GLint offset_y__,
+        const GLint offset_z__,
         const GLint size_x__,
         const GLint size_y__,
+        const GLint size_z__,
         void* data__)
     {
-        __GLW_HANDLE(glBindTexture(target_, *this)) {
-            return handle_error(__GLW_LAST_ERROR, "glBindTexture");
+        __GLW_PROFILE("Texture3D::read");
+        return this->readImage(lod__, format__, offset_x__, offset_y__, offset_z__, size_x__, size_y__, size_z__, data__);
+    }
+};
+
+// Layers of 2D images of one size and format, sampled with sampler2DArray
+// and selected by the third texture coordinate. Layers do not shrink with
+// the mip levels.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTexture2DArray : public BasicTexture3DBase<ErrorPolicy>
+{
+public:
+    BasicTexture2DArray(
+        const GLenum internal_format__,
+        const GLint levels__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint layers__,
+        GLuint* error = NULL)
+      : BasicTexture3DBase<ErrorPolicy>(
+            GL_TEXTURE_2D_ARRAY,
+            internal_format__,
+            levels__ > 0 ? levels__ : mip_levels(size_x__, size_y__),
+            size_x__,
+            size_y__,
+            layers__,
+            error)
+    {
+    }
+
+    BasicTexture2DArray(
+        const GLint internal_format__,
+        const ImageFormat& format__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint layers__,
+        const void* data__,
+        GLuint* error = NULL)
+      : BasicTexture3DBase<ErrorPolicy>(
+            GL_TEXTURE_2D_ARRAY,
+            internal_format__,
+            format__,
+            size_x__,
+            size_y__,
+            layers__,
+            data__,
+            error)
+    {
+    }
+
+    GLint layers() const { return this->size_z_; }
+};
+
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTexture3D : public BasicTexture3DBase<ErrorPolicy>
+{
+public:
+    BasicTexture3D(
+        const GLenum internal_format__,
+        const GLint levels__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        GLuint* error = NULL)
+      : BasicTexture3DBase<ErrorPolicy>(
+            GL_TEXTURE_3D,
+            internal_format__,
+            levels__ > 0 ? levels__ : mip_levels(size_x__, size_y__, size_z__),
+            size_x__,
+            size_y__,
+            size_z__,
+            error)
+    {
+    }
+
+    BasicTexture3D(
+        const GLint internal_format__,
+        const ImageFormat& format__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLint size_z__,
+        const void* data__,
+        GLuint* error = NULL)
+      : BasicTexture3DBase<ErrorPolicy>(
+            GL_TEXTURE_3D,
+            internal_format__,
+            format__,
+            size_x__,
+            size_y__,
+            size_z__,
+            data__,
+            error)
+    {
+    }
+};
+
+// Six square faces, numbered 0 to 5 in the order of
+// GL_TEXTURE_CUBE_MAP_POSITIVE_X and up.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTextureCube : public BasicTexture<ErrorPolicy>
+{
+protected:
+    using BasicTexture<ErrorPolicy>::target_;
+    using BasicTexture<ErrorPolicy>::size_x_;
+    using BasicTexture<ErrorPolicy>::levels_;
+
+public:
+    BasicTextureCube(
+        const GLenum internal_format__,
+        const GLint levels__,
+        const GLint size__,
+        GLuint* error = NULL)
+      : BasicTexture<ErrorPolicy>(
+            GL_TEXTURE_CUBE_MAP,
+            internal_format__,
+            size__,
+            size__,
+            6,
+            error,
+            levels__ > 0 ? levels__ : mip_levels(size__))
+    {
+        if(error && *error != GL_NO_ERROR) {
+            return;
+        }
+        if(!has_texture_storage()) {
+            if(error) *error = handle_error(GL_INVALID_OPERATION, "glTexStorage2D");
+            return;
+        }
+        __GLW_HANDLE(glTexStorage2D(target_, levels_, internal_format__, size_x_, size_x_)) {
+            if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexStorage2D");
+        }
+    }
+
+    // Mutable storage for level 0 only. faces__ holds the data of the six
+    // faces, or is NULL.
+    BasicTextureCube(
+        const GLint internal_format__,
+        const ImageFormat& format__,
+        const GLint size__,
+        const void* const* faces__,
+        GLuint* error = NULL)
+      : BasicTexture<ErrorPolicy>(GL_TEXTURE_CUBE_MAP, internal_format__, size__, size__, 6, error)
+    {
+        if(error && *error != GL_NO_ERROR) {
+            return;
+        }
+        for(GLint face = 0; face < 6; ++face) {
+            __GLW_HANDLE(glTexImage2D(
+                GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                0,
+                internal_format__,
+                size_x_,
+                size_x_,
+                0,
+                format__.order,
+                format__.type,
+                faces__ ? faces__[face] : NULL)) {
+                if(error) *error = handle_error(__GLW_LAST_ERROR, "glTexImage2D");
+                return;
+            }
+        }
+    }
+
+    GLuint write(
+        const GLint lod__,
+        const GLint face__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const void* data__)
+    {
+        __GLW_PROFILE("TextureCube::write");
+        GLuint error;
+        if((error = this->bind()) != GL_NO_ERROR) {
+            return error;
+        }
+        __GLW_HANDLE(glTexSubImage2D(
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + face__,
+            lod__,
+            offset_x__,
+            offset_y__,
+            size_x__,
+            size_y__,
+            format__.order,
+            format__.type,
+            data__)) {
+            return handle_error(__GLW_LAST_ERROR, "glTexSubImage2D");
+        }
+        __GLW_COUNT(bytes_uploaded, (GLuint64)sizeof_pixel(format__) * size_x__ * size_y__);
+        return GL_NO_ERROR;
+    }
+
+    // Writes a region of a block-compressed level of a face, see
+    // BasicTexture2D::writeCompressed.
+    GLuint writeCompressed(
+        const GLint lod__,
+        const GLint face__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        const GLsizei size__,
+        const void* data__)
+    {
+        __GLW_PROFILE("TextureCube::writeCompressed");
+        GLuint error;
+        if((error = this->bind()) != GL_NO_ERROR) {
+            return error;
         }
-        __GLW_HANDLE(glGetTexImage(target_, lod__, format__.order, format__.type, data__)) {
-            return handle_error(__GLW_LAST_ERROR, "glGetTexImage");
+        __GLW_HANDLE(glCompressedTexSubImage2D(
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + face__,
+            lod__,
+            offset_x__,
+            offset_y__,
+            size_x__,
+            size_y__,
+            this->format_,
+            size__,
+            data__)) {
+            return handle_error(__GLW_LAST_ERROR, "glCompressedTexSubImage2D");
         }
+        __GLW_COUNT(bytes_uploaded, size__);
         return GL_NO_ERROR;
     }
+
+    GLuint read(
+        const GLint lod__,
+        const GLint face__,
+        const ImageFormat& format__,
+        const GLint offset_x__,
+        const GLint offset_y__,
+        const GLint size_x__,
+        const GLint size_y__,
+        void* data__)
+    {
+        __GLW_PROFILE("TextureCube::read");
+        return this->readImage(lod__, format__, offset_x__, offset_y__, face__, size_x__, size_y__, 1, data__);
+    }
 };
 
+typedef BasicTexture<> Texture;
+typedef BasicTexture2D<> Texture2D;
+typedef BasicTexture2DArray<> Texture2DArray;
+typedef BasicTexture3D<> Texture3D;
+typedef BasicTextureCube<> TextureCube;
+
 } // namespace glw
 
 #endif
@@ -0,0 +1,350 @@
+
+#ifndef __GLW_TEXTURE_FILE_HPP
+#define __GLW_TEXTURE_FILE_HPP
+
+#include "glw_texture.hpp"
+
+#include <cstdio>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace glw {
+
+// 2D texture image with its mip levels in a KTX (version 1) or DDS file.
+// The file is memory-mapped and upload() hands each level to GL straight
+// from the mapping, e.g.
+//
+//   glw::TextureFile file("albedo.dds", &error);
+//   glw::Texture2D texture(file.internalFormat(), file.levels(), file.width(), file.height(), &error);
+//   file.upload(texture);
+//
+// Block-compressed levels go through glCompressedTexSubImage2D, so the
+// format must be one the context supports (see has_compressed_format).
+// Cube maps, arrays and volumes are rejected.
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicTextureFile
+{
+public:
+    struct Level
+    {
+        const GLubyte* data;
+        size_t size;
+        GLint size_x;
+        GLint size_y;
+    };
+
+private:
+    const GLubyte* contents_;
+    size_t size_;
+#ifdef _WIN32
+    std::vector<GLubyte> buffer_;
+#endif
+    GLenum internal_format_;
+    ImageFormat format_;
+    GLint size_x_;
+    GLint size_y_;
+    std::vector<Level> levels_;
+
+    BasicTextureFile(const BasicTextureFile&);
+
+    static GLuint read32(const GLubyte* data__)
+    {
+        return data__[0] | (data__[1] << 8) | (data__[2] << 16) | ((GLuint)data__[3] << 24);
+    }
+
+    static GLuint fourcc(const char* code__)
+    {
+        return read32((const GLubyte*)code__);
+    }
+
+    bool map(const std::string& path__)
+    {
+#ifndef _WIN32
+        const int fd = open(path__.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if(fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED) {
+                contents_ = (const GLubyte*)data;
+                size_ = info.st_size;
+            }
+        }
+        close(fd);
+#else
+        FILE* stream = fopen(path__.c_str(), "rb");
+        if(!stream) {
+            return false;
+        }
+        GLubyte chunk[4096];
+        size_t count;
+        while((count = fread(chunk, 1, sizeof(chunk), stream)) > 0) {
+            buffer_.insert(buffer_.end(), chunk, chunk + count);
+        }
+        fclose(stream);
+        if(!buffer_.empty()) {
+            contents_ = &buffer_[0];
+            size_ = buffer_.size();
+        }
+#endif
+        return contents_ != NULL;
+    }
+
+    // Size of a level in bytes, rows padded to alignment__.
+    size_t levelSize(const GLint size_x__, const GLint size_y__, const GLint alignment__) const
+    {
+        return compressed()
+            ? sizeof_compressed_image(internal_format_, size_x__, size_y__)
+            : sizeof_image(format_, size_x__, size_y__, 1, alignment__);
+    }
+
+    bool addLevel(const size_t offset__, const size_t size__)
+    {
+        const GLint lod = levels_.size();
+        const Level level = {
+            contents_ + offset__,
+            size__,
+            std::max(1, size_x_ >> lod),
+            std::max(1, size_y_ >> lod) };
+        if(offset__ > size_ || size__ > size_ - offset__) {
+            return false;
+        }
+        levels_.push_back(level);
+        return true;
+    }
+
+    GLuint parseKTX()
+    {
+        const GLubyte* header = contents_ + 12;
+        if(size_ < 64 || read32(header) != 0x04030201) {
+            // Big-endian files are not supported.
+            return GL_INVALID_OPERATION;
+        }
+        format_.type = read32(header + 4);
+        format_.order = read32(header + 12);
+        internal_format_ = read32(header + 16);
+        size_x_ = read32(header + 24);
+        size_y_ = std::max(1u, read32(header + 28));
+        const GLuint depth = read32(header + 32);
+        const GLuint elements = read32(header + 36);
+        const GLuint faces = read32(header + 40);
+        const GLuint levels = std::max(1u, read32(header + 44));
+        if(depth > 1 || elements > 0 || faces != 1 || size_x_ <= 0 || size_y_ <= 0
+            || levels > (GLuint)mip_levels(size_x_, size_y_)) {
+            return GL_INVALID_OPERATION;
+        }
+        if(compressed() != (sizeof_block(internal_format_) != 0)) {
+            return GL_INVALID_ENUM;
+        }
+
+        // Levels follow the key/value data, each prefixed by its size and
+        // padded to 4 bytes, rows padded to 4 bytes too.
+        size_t offset = 64 + read32(header + 48);
+        for(GLuint i = 0; i < levels; ++i) {
+            if(offset + 4 > size_) {
+                return GL_INVALID_OPERATION;
+            }
+            const size_t size = read32(contents_ + offset);
+            if(!addLevel(offset + 4, size) || size < levelSize(levels_.back().size_x, levels_.back().size_y, 4)) {
+                return GL_INVALID_OPERATION;
+            }
+            offset += 4 + (size + 3) / 4 * 4;
+        }
+        return GL_NO_ERROR;
+    }
+
+    GLuint formatDXGI(const GLuint format__)
+    {
+        const ImageFormat rgba = { GL_UNSIGNED_BYTE, GL_RGBA };
+        const ImageFormat bgra = { GL_UNSIGNED_BYTE, GL_BGRA };
+        switch(format__) {
+        case 28: internal_format_ = GL_RGBA8; format_ = rgba; break;
+        case 29: internal_format_ = GL_SRGB8_ALPHA8; format_ = rgba; break;
+        case 87: internal_format_ = GL_RGBA8; format_ = bgra; break;
+        case 91: internal_format_ = GL_SRGB8_ALPHA8; format_ = bgra; break;
+        case 71: internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+        case 72: internal_format_ = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; break;
+        case 74: internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; break;
+        case 75: internal_format_ = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT; break;
+        case 77: internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+        case 78: internal_format_ = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; break;
+        case 80: internal_format_ = GL_COMPRESSED_RED_RGTC1; break;
+        case 81: internal_format_ = GL_COMPRESSED_SIGNED_RED_RGTC1; break;
+        case 83: internal_format_ = GL_COMPRESSED_RG_RGTC2; break;
+        case 84: internal_format_ = GL_COMPRESSED_SIGNED_RG_RGTC2; break;
+        case 95: internal_format_ = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT; break;
+        case 96: internal_format_ = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT; break;
+        case 98: internal_format_ = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+        case 99: internal_format_ = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM; break;
+        default: return GL_INVALID_ENUM;
+        }
+        return GL_NO_ERROR;
+    }
+
+    GLuint parseDDS()
+    {
+        // DDS_HEADER follows the magic, DDS_HEADER_DXT10 optionally follows
+        // it, then the levels, tightly packed.
+        const GLubyte* header = contents_ + 4;
+        if(size_ < 128 || read32(header) != 124) {
+            return GL_INVALID_OPERATION;
+        }
+        size_y_ = read32(header + 8);
+        size_x_ = read32(header + 12);
+        const GLuint levels = std::max(1u, read32(header + 24));
+        const GLubyte* pixel_format = header + 72;
+        const GLuint flags = read32(pixel_format + 4);
+        const GLuint code = read32(pixel_format + 8);
+        const GLuint caps2 = read32(header + 108);
+        size_t offset = 128;
+        if(size_x_ <= 0 || size_y_ <= 0 || (caps2 & 0x200200) != 0
+            || levels > (GLuint)mip_levels(size_x_, size_y_)) {
+            // Cube maps and volumes, or a corrupt header.
+            return GL_INVALID_OPERATION;
+        }
+
+        GLuint error = GL_NO_ERROR;
+        if(flags & 0x4) {
+            if(code == fourcc("DX10")) {
+                if(size_ < 148) {
+                    return GL_INVALID_OPERATION;
+                }
+                const GLubyte* extension = contents_ + 128;
+                if(read32(extension + 4) != 3 || read32(extension + 12) > 1) {
+                    return GL_INVALID_OPERATION;
+                }
+                error = formatDXGI(read32(extension));
+                offset = 148;
+            } else if(code == fourcc("DXT1")) {
+                internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            } else if(code == fourcc("DXT3")) {
+                internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            } else if(code == fourcc("DXT5")) {
+                internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            } else if(code == fourcc("ATI1") || code == fourcc("BC4U")) {
+                internal_format_ = GL_COMPRESSED_RED_RGTC1;
+            } else if(code == fourcc("ATI2") || code == fourcc("BC5U")) {
+                internal_format_ = GL_COMPRESSED_RG_RGTC2;
+            } else {
+                error = GL_INVALID_ENUM;
+            }
+        } else if((flags & 0x40) && read32(pixel_format + 12) == 32) {
+            // 32-bit RGB(A) masks, in either byte order.
+            const GLuint red = read32(pixel_format + 16);
+            const GLuint blue = read32(pixel_format + 24);
+            const ImageFormat rgba = { GL_UNSIGNED_BYTE, GL_RGBA };
+            const ImageFormat bgra = { GL_UNSIGNED_BYTE, GL_BGRA };
+            internal_format_ = GL_RGBA8;
+            if(red == 0xff && blue == 0xff0000) {
+                format_ = rgba;
+            } else if(red == 0xff0000 && blue == 0xff) {
+                format_ = bgra;
+            } else {
+                error = GL_INVALID_ENUM;
+            }
+        } else {
+            error = GL_INVALID_ENUM;
+        }
+        if(error != GL_NO_ERROR) {
+            return error;
+        }
+
+        for(GLuint i = 0; i < levels; ++i) {
+            const size_t size = levelSize(std::max(1, size_x_ >> i), std::max(1, size_y_ >> i), 1);
+            if(!addLevel(offset, size)) {
+                return GL_INVALID_OPERATION;
+            }
+            offset += size;
+        }
+        return GL_NO_ERROR;
+    }
+
+public:
+    BasicTextureFile(const std::string& path__, GLuint* error = NULL)
+      : contents_(NULL),
+        size_(0),
+        internal_format_(GL_NONE),
+        size_x_(0),
+        size_y_(0)
+    {
+        format_.type = GL_NONE;
+        format_.order = GL_NONE;
+
+        GLuint result = GL_INVALID_OPERATION;
+        if(map(path__) && size_ >= 12) {
+            static const GLubyte ktx[12] = { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+            if(memcmp(contents_, ktx, sizeof(ktx)) == 0) {
+                result = parseKTX();
+            } else if(read32(contents_) == fourcc("DDS ")) {
+                result = parseDDS();
+            }
+        }
+        if(result != GL_NO_ERROR) {
+            levels_.clear();
+            if(error) *error = handle_error(result, "TextureFile");
+        }
+    }
+
+    ~BasicTextureFile()
+    {
+#ifndef _WIN32
+        if(contents_) {
+            munmap((void*)contents_, size_);
+        }
+#endif
+    }
+
+    // Writes the levels of the file to those of texture__, which has the
+    // internal format and size of the file.
+    GLuint upload(BasicTexture2D<ErrorPolicy>& texture__) const
+    {
+        if(levels_.empty()) {
+            return handle_error(GL_INVALID_OPERATION, "TextureFile::upload");
+        }
+        GLuint error = StateCache::current().bindBuffer<ErrorPolicy>(GL_PIXEL_UNPACK_BUFFER, 0);
+        GLint alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        // KTX pads rows to 4 bytes; DDS uncompressed rows are always 4-byte
+        // pixels.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        const GLint levels = std::min((GLint)levels_.size(), texture__.levels());
+        for(GLint i = 0; i < levels && error == GL_NO_ERROR; ++i) {
+            const Level& level = levels_[i];
+            if(compressed()) {
+                error = texture__.writeCompressed(
+                    i, 0, 0, level.size_x, level.size_y,
+                    sizeof_compressed_image(internal_format_, level.size_x, level.size_y),
+                    level.data);
+            } else {
+                error = texture__.write(i, format_, 0, 0, level.size_x, level.size_y, level.data);
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        return error;
+    }
+
+    bool valid() const { return !levels_.empty(); }
+    bool compressed() const { return format_.type == GL_NONE; }
+    GLenum internalFormat() const { return internal_format_; }
+    const ImageFormat& format() const { return format_; }
+    GLint width() const { return size_x_; }
+    GLint height() const { return size_y_; }
+    GLint levels() const { return levels_.size(); }
+    const Level& level(const GLint lod__) const { return levels_[lod__]; }
+};
+
+typedef BasicTextureFile<> TextureFile;
+
+} // namespace
+
+#endif
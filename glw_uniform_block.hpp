@@ -0,0 +1,174 @@
+
+#ifndef __GLW_UNIFORM_BLOCK_HPP
+#define __GLW_UNIFORM_BLOCK_HPP
+
+#include "glw_buffer.hpp"
+#include "glw_program.hpp"
+
+namespace glw {
+
+// Uniform buffer laid out after a block reflected from a program, usually
+// declared with layout(std140) so that every program declaring the block
+// agrees on it. Values are packed into a CPU copy and only the modified
+// range is uploaded, once, when the block is bound; programs then read it
+// from the binding point set with Program::bindBlock().
+template <class ErrorPolicy = DefaultErrorPolicy>
+class BasicUniformBlock
+{
+public:
+    struct MemberHandle
+    {
+        GLint index;
+        bool valid() const { return index >= 0; }
+    };
+
+private:
+    BlockLayout layout_;
+    BasicBuffer<ErrorPolicy> buffer_;
+    std::vector<GLubyte> data_;
+    size_t dirty_begin_;
+    size_t dirty_end_;
+
+    BasicUniformBlock(const BasicUniformBlock&);
+
+    // Columns of matrix types, matNxM having N columns of M rows.
+    static GLint columns(const GLenum type__)
+    {
+        switch(type__) {
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT2x4:   return 2;
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4:   return 3;
+        case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT4x2:
+        case GL_FLOAT_MAT4x3:   return 4;
+        default:                return 1;
+        }
+    }
+
+    static bool matchName(const std::string& member__, const GLchar* name__)
+    {
+        // Arrays are reported as "name[0]" but may be set by "name".
+        const size_t length = strlen(name__);
+        return member__.compare(0, length, name__) == 0
+            && (member__.size() == length || member__.compare(length, std::string::npos, "[0]") == 0);
+    }
+
+    void touch(const size_t begin__, const size_t end__)
+    {
+        dirty_begin_ = std::min(dirty_begin_, begin__);
+        dirty_end_ = std::max(dirty_end_, end__);
+    }
+
+public:
+    BasicUniformBlock(const BlockLayout& layout__, GLuint* error = NULL)
+      : layout_(layout__),
+        buffer_(GL_UNIFORM_BUFFER, GL_DYNAMIC_DRAW, layout__.size, NULL, error),
+        data_(layout__.size, 0),
+        dirty_begin_(layout__.size),
+        dirty_end_(0)
+    {
+    }
+
+    MemberHandle memberHandle(const GLchar* name__) const
+    {
+        MemberHandle handle = { -1 };
+        for(size_t i = 0; i < layout_.members.size(); ++i) {
+            if(matchName(layout_.members[i].name, name__)) {
+                handle.index = i;
+                break;
+            }
+        }
+        return handle;
+    }
+
+    template <typename T>
+    GLuint set(const GLchar* name__, const T& value__, const GLuint count__ = 1)
+    {
+        return set(memberHandle(name__), value__, count__);
+    }
+
+    // Packs count__ tightly packed values of type T, e.g. count__ floats
+    // of a float[] member or 16 * count__ floats of a mat4[] member, with
+    // the member's array and matrix strides. Matrices are given column by
+    // column and transposed for row_major members. Booleans are GLints.
+    template <typename T>
+    GLuint set(const MemberHandle handle__, const T& value__, const GLuint count__ = 1)
+    {
+        if(!handle__.valid() || handle__.index >= (GLint)layout_.members.size()) {
+            return handle_error(GL_INVALID_VALUE, "UniformBlock::set");
+        }
+        const BlockMember& member = layout_.members[handle__.index];
+        const size_t element_size = sizeof_type(member.type);
+        const size_t size = sizeof(T) * count__;
+        if(size > element_size * member.size || size % element_size != 0) {
+            return handle_error(GL_INVALID_VALUE, "UniformBlock::set");
+        }
+        if(size == 0) {
+            return GL_NO_ERROR;
+        }
+
+        // Non-matrix elements are copied whole, matrices a float at a time.
+        const GLint column_count = columns(member.type);
+        const bool matrix = column_count > 1;
+        const GLint row_count = matrix ? element_size / sizeof(GLfloat) / column_count : 1;
+        const size_t component_size = matrix ? sizeof(GLfloat) : element_size;
+        const bool row_major = matrix && member.row_major;
+        const size_t column_stride = row_major ? component_size : member.matrix_stride;
+        const size_t row_stride = row_major ? member.matrix_stride : component_size;
+        const size_t array_stride = member.array_stride ? member.array_stride : element_size;
+        const GLubyte* source = (const GLubyte*)&value__;
+        const size_t elements = size / element_size;
+        for(size_t i = 0; i < elements; ++i) {
+            GLubyte* target = &data_[member.offset + i * array_stride];
+            for(GLint j = 0; j < column_count; ++j) {
+                for(GLint k = 0; k < row_count; ++k) {
+                    memcpy(target + j * column_stride + k * row_stride, source, component_size);
+                    source += component_size;
+                }
+            }
+        }
+        const size_t last = (column_count - 1) * column_stride + (row_count - 1) * row_stride;
+        touch(member.offset, member.offset + (elements - 1) * array_stride + last + component_size);
+        return GL_NO_ERROR;
+    }
+
+    // Uploads the values modified since the last flush.
+    GLuint flush()
+    {
+        __GLW_PROFILE("UniformBlock::flush");
+        if(dirty_begin_ >= dirty_end_) {
+            return GL_NO_ERROR;
+        }
+        GLuint error;
+        if((error = buffer_.write(dirty_begin_, dirty_end_ - dirty_begin_, &data_[dirty_begin_])) != GL_NO_ERROR) {
+            return error;
+        }
+        dirty_begin_ = data_.size();
+        dirty_end_ = 0;
+        return GL_NO_ERROR;
+    }
+
+    // Flushes and binds the block to a uniform buffer binding point.
+    GLuint bind(const GLuint binding__)
+    {
+        GLuint error;
+        if((error = flush()) != GL_NO_ERROR) {
+            return error;
+        }
+        return StateCache::current().bindBufferBase<ErrorPolicy>(GL_UNIFORM_BUFFER, binding__, buffer_.id());
+    }
+
+    const BlockLayout& layout() const { return layout_; }
+    const std::vector<GLubyte>& data() const { return data_; }
+    BasicBuffer<ErrorPolicy>& buffer() { return buffer_; }
+    GLuint id() const { return buffer_.id(); }
+};
+
+typedef BasicUniformBlock<> UniformBlock;
+
+} // namespace
+
+#endif
@@ -0,0 +1,109 @@
+
+#ifndef __GLW_VERTEX_LAYOUT_HPP
+#define __GLW_VERTEX_LAYOUT_HPP
+
+#include "glw.hpp"
+
+#include <cstddef>
+
+namespace glw {
+
+// Storage types without a C++ equivalent, filled in by the packers of
+// glw_vertex_pack.hpp.
+struct Half
+{
+    GLushort bits;
+};
+
+// Four signed components of 10, 10, 10 and 2 bits, x in the low bits.
+struct Int2101010
+{
+    GLuint bits;
+};
+
+// GL component type and count of a vertex member type.
+template <typename T> struct VertexComponent;
+
+#define __GLW_IMPL_VERTEX_COMPONENT(Type, GLType) \
+    template <> struct VertexComponent<Type> { \
+        static const GLenum type = GLType; \
+        static const GLint count = 1; };
+__GLW_IMPL_VERTEX_COMPONENT(GLfloat,    GL_FLOAT)
+__GLW_IMPL_VERTEX_COMPONENT(GLdouble,   GL_DOUBLE)
+__GLW_IMPL_VERTEX_COMPONENT(GLbyte,     GL_BYTE)
+__GLW_IMPL_VERTEX_COMPONENT(GLubyte,    GL_UNSIGNED_BYTE)
+__GLW_IMPL_VERTEX_COMPONENT(GLshort,    GL_SHORT)
+__GLW_IMPL_VERTEX_COMPONENT(GLushort,   GL_UNSIGNED_SHORT)
+__GLW_IMPL_VERTEX_COMPONENT(GLint,      GL_INT)
+__GLW_IMPL_VERTEX_COMPONENT(GLuint,     GL_UNSIGNED_INT)
+__GLW_IMPL_VERTEX_COMPONENT(Half,       GL_HALF_FLOAT)
+#undef __GLW_IMPL_VERTEX_COMPONENT
+
+template <>
+struct VertexComponent<Int2101010>
+{
+    static const GLenum type = GL_INT_2_10_10_10_REV;
+    static const GLint count = 4;
+};
+
+template <typename T, size_t N>
+struct VertexComponent<T[N]>
+{
+    static const GLenum type = VertexComponent<T>::type;
+    static const GLint count = N * VertexComponent<T>::count;
+};
+
+// Format of one attribute within an interleaved vertex. Normalized
+// integers are read as floats in [0, 1] or [-1, 1]. Integer formats feed
+// integer shader inputs (int, ivec*, uint) unconverted.
+struct VertexFormat
+{
+    GLint components;
+    GLenum type;
+    size_t offset;
+    GLboolean normalized;
+};
+
+template <typename Member, size_t Offset, bool Normalized = false>
+struct VertexField
+{
+    static const GLenum type = VertexComponent<Member>::type;
+    static const GLint components = VertexComponent<Member>::count;
+    static const size_t offset = Offset;
+    static const GLboolean normalized = Normalized;
+
+    static_assert(components >= 1 && components <= 4, "vertex fields have 1 to 4 components");
+};
+
+// Names the field of a vertex struct for VertexLayout.
+#define __GLW_VERTEX_FIELD(Vertex, Member) \
+    glw::VertexField<decltype(((Vertex*)0)->Member), offsetof(Vertex, Member)>
+
+// Same, for integer data normalized to [0, 1] or [-1, 1].
+#define __GLW_VERTEX_FIELD_NORMALIZED(Vertex, Member) \
+    glw::VertexField<decltype(((Vertex*)0)->Member), offsetof(Vertex, Member), true>
+
+// Interleaved layout of a vertex struct, e.g.
+//
+//   struct Vertex { GLfloat position[3]; GLfloat texcoord[2]; };
+//   typedef glw::VertexLayout<Vertex,
+//       __GLW_VERTEX_FIELD(Vertex, position),
+//       __GLW_VERTEX_FIELD(Vertex, texcoord)> Layout;
+//
+// bound to a program with Program::setAttributes<Layout>().
+template <typename Vertex, typename... Fields>
+struct VertexLayout
+{
+    static const size_t stride = sizeof(Vertex);
+    static const size_t fields = sizeof...(Fields);
+
+    static const VertexFormat* formats()
+    {
+        static const VertexFormat result[] = { { Fields::components, Fields::type, Fields::offset, Fields::normalized }... };
+        return result;
+    }
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,174 @@
+
+#ifndef __GLW_VERTEX_PACK_HPP
+#define __GLW_VERTEX_PACK_HPP
+
+#include "glw_vertex_layout.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define __GLW_PACK_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace glw {
+
+// Converters from float arrays into the compact vertex formats of
+// VertexComponent. Each converts count values, in blocks of four with
+// SSE2 (and F16C for halves) when available. Normalized conversions clamp
+// and round to nearest even, matching the SIMD conversions.
+
+static inline Half pack_half(const GLfloat value)
+{
+    GLuint bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const GLushort sign = (bits >> 16) & 0x8000;
+    const GLint exponent = (GLint)((bits >> 23) & 0xff) - 127 + 15;
+    GLuint mantissa = bits & 0x7fffff;
+    Half result;
+
+    if(((bits >> 23) & 0xff) == 0xff) {
+        // Infinity or NaN.
+        result.bits = sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    } else if(exponent >= 31) {
+        result.bits = sign | 0x7c00;
+    } else if(exponent <= 0) {
+        // Denormal or zero, rounded to nearest even.
+        if(exponent < -10) {
+            result.bits = sign;
+            return result;
+        }
+        mantissa |= 0x800000;
+        const GLuint shift = 14 - exponent;
+        const GLuint remainder = mantissa & ((1u << shift) - 1);
+        const GLuint halfway = 1u << (shift - 1);
+        GLuint half = mantissa >> shift;
+        if(remainder > halfway || (remainder == halfway && (half & 1))) ++half;
+        result.bits = sign | half;
+    } else {
+        // Rounding may carry into the exponent, up to infinity.
+        const GLuint remainder = mantissa & 0x1fff;
+        GLuint half = ((GLuint)exponent << 10) | (mantissa >> 13);
+        if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) ++half;
+        result.bits = sign | half;
+    }
+    return result;
+}
+
+static inline void pack_half(const GLfloat* in, Half* out, const size_t count)
+{
+    size_t i = 0;
+#if defined(__F16C__)
+    for(; i + 4 <= count; i += 4) {
+        const __m128i half = _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storel_epi64((__m128i*)(out + i), half);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = pack_half(in[i]);
+    }
+}
+
+static inline GLint pack_normalized(GLfloat value, const GLfloat low, const GLfloat scale)
+{
+    value = value < low ? low : (value > 1.0f ? 1.0f : value);
+    return (GLint)std::nearbyint(value * scale);
+}
+
+static inline void pack_snorm8(const GLfloat* in, GLbyte* out, const size_t count)
+{
+    size_t i = 0;
+#ifdef __GLW_PACK_SSE2
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(127.0f);
+    for(; i + 4 <= count; i += 4) {
+        const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high);
+        const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(value, scale)), _mm_setzero_si128());
+        const GLint bytes = _mm_cvtsi128_si32(_mm_packs_epi16(words, words));
+        memcpy(out + i, &bytes, 4);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = (GLbyte)pack_normalized(in[i], -1.0f, 127.0f);
+    }
+}
+
+static inline void pack_unorm8(const GLfloat* in, GLubyte* out, const size_t count)
+{
+    size_t i = 0;
+#ifdef __GLW_PACK_SSE2
+    const __m128 low = _mm_setzero_ps();
+    const __m128 high = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    for(; i + 4 <= count; i += 4) {
+        const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high);
+        const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(value, scale)), _mm_setzero_si128());
+        const GLint bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        memcpy(out + i, &bytes, 4);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = (GLubyte)pack_normalized(in[i], 0.0f, 255.0f);
+    }
+}
+
+static inline void pack_snorm16(const GLfloat* in, GLshort* out, const size_t count)
+{
+    size_t i = 0;
+#ifdef __GLW_PACK_SSE2
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    for(; i + 4 <= count; i += 4) {
+        const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high);
+        const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(value, scale)), _mm_setzero_si128());
+        _mm_storel_epi64((__m128i*)(out + i), words);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = (GLshort)pack_normalized(in[i], -1.0f, 32767.0f);
+    }
+}
+
+static inline void pack_unorm16(const GLfloat* in, GLushort* out, const size_t count)
+{
+    size_t i = 0;
+#ifdef __GLW_PACK_SSE2
+    const __m128 low = _mm_setzero_ps();
+    const __m128 high = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(65535.0f);
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16((short)0x8000);
+    for(; i + 4 <= count; i += 4) {
+        // SSE2 lacks an unsigned 32 to 16 bit pack, so pack biased values.
+        const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high);
+        const __m128i biased = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(value, scale)), bias);
+        const __m128i words = _mm_xor_si128(_mm_packs_epi32(biased, _mm_setzero_si128()), flip);
+        _mm_storel_epi64((__m128i*)(out + i), words);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = (GLushort)pack_normalized(in[i], 0.0f, 65535.0f);
+    }
+}
+
+// Packs count xyzw quadruples, typically normals or tangents with w = 0.
+static inline void pack_2_10_10_10(const GLfloat* in, Int2101010* out, const size_t count)
+{
+    for(size_t i = 0; i < count; ++i) {
+        const GLfloat* v = in + i * 4;
+        const GLuint x = pack_normalized(v[0], -1.0f, 511.0f) & 0x3ff;
+        const GLuint y = pack_normalized(v[1], -1.0f, 511.0f) & 0x3ff;
+        const GLuint z = pack_normalized(v[2], -1.0f, 511.0f) & 0x3ff;
+        const GLuint w = pack_normalized(v[3], -1.0f, 1.0f) & 0x3;
+        out[i].bits = x | (y << 10) | (z << 20) | (w << 30);
+    }
+}
+
+} // namespace
+
+#endif
@@ -32,6 +32,51 @@ int main()
 
     TEST_ASSERT(memcmp(write_data, read_data, sizeof(int)*16) == 0);
 
+    // Asynchronous reads go through a staging copy.
+    glw::ReadTicket ticket;
+    error = buffer_b.readAsync(sizeof(int)*2, sizeof(int)*8, ticket);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    while(!ticket.ready()) {}
+    memset(read_data, 0, sizeof(read_data));
+    error = ticket.read(read_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(ticket.size() == sizeof(int)*8);
+    TEST_ASSERT(memcmp(write_data+2, read_data, sizeof(int)*8) == 0);
+
+    // Repeated writes to the same buffer bind it once.
+    glw::StateCache& state = glw::StateCache::current();
+    state.resetStats();
+    TEST_ASSERT(buffer_b.write(0, sizeof(write_data), write_data) == GL_NO_ERROR);
+    TEST_ASSERT(buffer_b.write(0, sizeof(write_data), write_data) == GL_NO_ERROR);
+    TEST_ASSERT(state.stats().misses == 1);
+    TEST_ASSERT(state.stats().hits == 1);
+    state.invalidate();
+    TEST_ASSERT(buffer_b.write(0, sizeof(write_data), write_data) == GL_NO_ERROR);
+    TEST_ASSERT(state.stats().misses == 2);
+
+    // Capabilities are answered from the cache after the first query.
+    const bool invalidate_subdata = glw::has_version(4, 3) || glw::has_extension("GL_ARB_invalidate_subdata");
+    TEST_ASSERT(state.supports(glw::StateCache::CAPABILITY_INVALIDATE_SUBDATA) == invalidate_subdata);
+    state.invalidate();
+    TEST_ASSERT(state.supports(glw::StateCache::CAPABILITY_INVALIDATE_SUBDATA) == invalidate_subdata);
+
+    glw::BasicBuffer<glw::CheckDeferred> buffer_c (GL_ARRAY_BUFFER, GL_STATIC_DRAW, sizeof(write_data), NULL, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(glw::CheckDeferred::flush("frame") == GL_NO_ERROR);
+
+    // Out of range writes are only reported at the next flush.
+    error = buffer_c.write(sizeof(write_data), sizeof(write_data), write_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(glw::CheckDeferred::flush("frame") == GL_INVALID_VALUE);
+
+    // The unattributed error above makes the next frame name the culprit.
+    error = buffer_c.write(sizeof(write_data), sizeof(write_data), write_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(glw::CheckDeferred::state().function != NULL);
+    TEST_ASSERT(strncmp(glw::CheckDeferred::state().function, "glBufferSubData", 15) == 0);
+    TEST_ASSERT(glw::CheckDeferred::flush("frame") == GL_INVALID_VALUE);
+    TEST_ASSERT(glw::CheckDeferred::flush("frame") == GL_NO_ERROR);
+
     return EXIT_SUCCESS;
 }
 
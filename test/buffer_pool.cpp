@@ -0,0 +1,138 @@
+#include "test.hpp"
+#include "glw_buffer_pool.hpp"
+#include "glw_program.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+    const size_t page_size = 4096;
+    const size_t stride = 12;
+
+    // Ranges are aligned, do not overlap and fill pages before new ones
+    // are created.
+    glw::BufferPool pool(GL_ARRAY_BUFFER, GL_STATIC_DRAW, page_size);
+    std::vector<glw::BufferPool::Allocation> allocations;
+    for(int i = 0; i < 24; ++i) {
+        allocations.push_back(pool.allocate(stride * (i + 1), stride, &error));
+        TEST_ASSERT(error == GL_NO_ERROR && allocations.back().valid());
+        TEST_ASSERT(pool.range(allocations.back()).offset % stride == 0);
+    }
+    for(size_t i = 0; i < allocations.size(); ++i) {
+        const glw::BufferPool::Range a = pool.range(allocations[i]);
+        TEST_ASSERT(a.offset + a.size <= page_size);
+        for(size_t j = i + 1; j < allocations.size(); ++j) {
+            const glw::BufferPool::Range b = pool.range(allocations[j]);
+            TEST_ASSERT(a.buffer != b.buffer || a.offset + a.size <= b.offset || b.offset + b.size <= a.offset);
+        }
+    }
+    TEST_ASSERT(pool.used() == stride * 24 * 25 / 2);
+    TEST_ASSERT(pool.capacity() == pool.pages() * page_size);
+
+    // Each range keeps its data when ranges are moved.
+    for(size_t i = 0; i < allocations.size(); ++i) {
+        std::vector<GLubyte> data(pool.range(allocations[i]).size, (GLubyte)i);
+        TEST_ASSERT(pool.write(allocations[i], 0, data.size(), &data[0]) == GL_NO_ERROR);
+    }
+    for(size_t i = 0; i < allocations.size(); i += 2) {
+        TEST_ASSERT(pool.free(allocations[i]) == GL_NO_ERROR);
+        TEST_ASSERT(!allocations[i].valid());
+    }
+    TEST_ASSERT(pool.free(allocations[0]) == GL_INVALID_VALUE);
+
+    // A copy of a freed allocation does not refer to the one reusing its
+    // entry.
+    glw::BufferPool::Allocation kept = allocations[1];
+    glw::BufferPool::Allocation stale = kept;
+    TEST_ASSERT(pool.free(kept) == GL_NO_ERROR);
+    allocations[1] = pool.allocate(stride * 2, stride, &error);
+    TEST_ASSERT(error == GL_NO_ERROR && allocations[1].index == stale.index);
+    TEST_ASSERT(pool.range(stale).buffer == 0);
+    TEST_ASSERT(pool.write(stale, 0, 1, &stride) == GL_INVALID_VALUE);
+    TEST_ASSERT(pool.free(stale) == GL_INVALID_VALUE);
+    const std::vector<GLubyte> reused(stride * 2, 1);
+    TEST_ASSERT(pool.write(allocations[1], 0, reused.size(), &reused[0]) == GL_NO_ERROR);
+
+    const size_t pages = pool.pages();
+    const GLuint generation = pool.generation();
+    TEST_ASSERT(pool.defragment() == GL_NO_ERROR);
+    TEST_ASSERT(pool.pages() <= pages);
+    TEST_ASSERT(pool.compact() == GL_NO_ERROR);
+    TEST_ASSERT(pool.generation() != generation);
+    TEST_ASSERT(pool.pages() < pages);
+    for(size_t i = 1; i < allocations.size(); i += 2) {
+        std::vector<GLubyte> data(pool.range(allocations[i]).size);
+        TEST_ASSERT(pool.read(allocations[i], 0, data.size(), &data[0]) == GL_NO_ERROR);
+        TEST_ASSERT(data.front() == (GLubyte)i && data.back() == (GLubyte)i);
+    }
+
+    // Freed blocks merge back into whole pages.
+    for(size_t i = 1; i < allocations.size(); i += 2) {
+        TEST_ASSERT(pool.free(allocations[i]) == GL_NO_ERROR);
+    }
+    TEST_ASSERT(pool.used() == 0);
+    const size_t capacity = pool.capacity();
+    glw::BufferPool::Allocation whole = pool.allocate(page_size, 16, &error);
+    TEST_ASSERT(error == GL_NO_ERROR && pool.capacity() == capacity);
+    TEST_ASSERT(pool.free(whole) == GL_NO_ERROR);
+    TEST_ASSERT(pool.defragment() == GL_NO_ERROR);
+    TEST_ASSERT(pool.pages() == 0);
+
+    // Two meshes sharing one vertex and one index buffer, drawn with the
+    // same vertex array. The second covers the viewport.
+    const char* vsource =
+        "#version 330\n"
+        "in vec3 v_position;"
+        "void main() { gl_Position = vec4(v_position, 1); }";
+    const char* fsource =
+        "#version 330\n"
+        "out vec4 f_color;"
+        "void main() { f_color = vec4(1,0,0,1); }";
+    const GLfloat hidden[3*3] = { 0,0,0, 0,0,0, 0,0,0 };
+    const GLfloat screen[4*3] = { -1,-1,0, 1,-1,0, 1,1,0, -1,1,0 };
+    const GLushort hidden_indices[3] = { 0, 1, 2 };
+    const GLushort screen_indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    glw::BufferPool vertices(GL_ARRAY_BUFFER, GL_STATIC_DRAW, page_size);
+    glw::BufferPool indices(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, page_size);
+    glw::BufferPool::Allocation meshes[2][2] = {
+        { vertices.allocate(sizeof(hidden), stride), indices.allocate(sizeof(hidden_indices), 2) },
+        { vertices.allocate(sizeof(screen), stride), indices.allocate(sizeof(screen_indices), 2) } };
+    TEST_ASSERT(vertices.write(meshes[0][0], 0, sizeof(hidden), hidden) == GL_NO_ERROR);
+    TEST_ASSERT(vertices.write(meshes[1][0], 0, sizeof(screen), screen) == GL_NO_ERROR);
+    TEST_ASSERT(indices.write(meshes[0][1], 0, sizeof(hidden_indices), hidden_indices) == GL_NO_ERROR);
+    TEST_ASSERT(indices.write(meshes[1][1], 0, sizeof(screen_indices), screen_indices) == GL_NO_ERROR);
+    TEST_ASSERT(vertices.pages() == 1 && indices.pages() == 1);
+
+    glw::Program::Shaders shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program program(shaders, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(program.build() == GL_NO_ERROR);
+    TEST_ASSERT(program.setAttribute("v_position", vertices.page(0).id()) == GL_NO_ERROR);
+
+    glViewport(0, 0, test_width, test_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    for(int i = 0; i < 2; ++i) {
+        const glw::BufferPool::Range vertex_range = vertices.range(meshes[i][0]);
+        const glw::BufferPool::Range index_range = indices.range(meshes[i][1]);
+        error = program.execute(
+            GL_TRIANGLES,
+            index_range.size / sizeof(GLushort),
+            GL_UNSIGNED_SHORT,
+            index_range.buffer,
+            index_range.offset / sizeof(GLushort),
+            vertex_range.offset / stride);
+        TEST_ASSERT(error == GL_NO_ERROR);
+    }
+    TEST_ASSERT(program.vertexArrays() == 1);
+
+    GLubyte pixel[4] = {0};
+    glReadPixels(test_width / 2, test_height / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    TEST_ASSERT(pixel[0] == 255 && pixel[1] == 0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#ifndef __GLW_ENABLE_COUNTERS
+#define __GLW_ENABLE_COUNTERS
+#endif
+#include "test.hpp"
+#include "glw_buffer.hpp"
+#include "glw_pixel_transfer.hpp"
+#include "glw_program.hpp"
+#include "glw_texture.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+
+    const char* vsource =
+        "#version 330\n"
+        "in vec2 v_position;"
+        "uniform float u_time;"
+        "void main() { gl_Position = vec4(v_position, u_time, 1); }";
+    const char* fsource =
+        "#version 330\n"
+        "out vec4 f_color;"
+        "void main() { f_color = vec4(1,0,0,1); }";
+    const float data[2*3] = {0};
+    float read_data[2*3];
+    const GLubyte texels[4*4*4] = {0};
+    GLubyte read_texels[4*4*4];
+
+    glw::Buffer buffer(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW, sizeof(data), NULL, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    glw::Texture2D texture(GL_RGBA8, 1, 4, 4, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    glw::Program::Shaders shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program program(shaders, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(program.build() == GL_NO_ERROR);
+    TEST_ASSERT(program.setAttribute("v_position", buffer.id()) == GL_NO_ERROR);
+    glw::StateCache::current().useProgram<glw::DefaultErrorPolicy>(0);
+
+    // One frame's worth of work, measured as the difference of snapshots.
+    const glw::Counters begin = glw::counters();
+
+    TEST_ASSERT(buffer.write(0, sizeof(data), data) == GL_NO_ERROR);
+    TEST_ASSERT(buffer.read(0, sizeof(data), read_data) == GL_NO_ERROR);
+    const glw::ImageFormat format = { GL_UNSIGNED_BYTE, GL_RGBA };
+    TEST_ASSERT(texture.write(0, format, 0, 0, 4, 4, texels) == GL_NO_ERROR);
+    TEST_ASSERT(texture.read(0, format, 0, 0, 4, 4, read_texels) == GL_NO_ERROR);
+    TEST_ASSERT(program.setUniform("u_time", 0.5f) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+
+    const glw::Counters frame = glw::counters() - begin;
+    TEST_ASSERT(frame.bytes_uploaded == sizeof(data) + sizeof(texels));
+    TEST_ASSERT(frame.bytes_read == sizeof(data) + sizeof(texels));
+    TEST_ASSERT(frame.program_switches == 1);
+    TEST_ASSERT(frame.uniform_uploads == 1);
+    TEST_ASSERT(frame.gl_calls > 0);
+    TEST_ASSERT(frame.error_checks == frame.gl_calls);
+
+    // GL calls are attributed to the method issuing them.
+    TEST_ASSERT(frame.calls("Buffer::write") >= 1);
+    TEST_ASSERT(frame.calls("Program::execute") >= 2);
+    TEST_ASSERT(frame.calls("Program::executeIndirect") == 0);
+
+    // Snapshots add up, e.g. over threads.
+    const glw::Counters total = begin + frame;
+    TEST_ASSERT(total.gl_calls == glw::counters().gl_calls);
+    TEST_ASSERT(total.calls("Buffer::write") == glw::counters().calls("Buffer::write"));
+
+    // A read through a pack buffer is counted once, when the buffer is read.
+    glw::PixelTransfer transfer;
+    size_t ticket;
+    const glw::Counters before_read = glw::counters();
+    TEST_ASSERT(transfer.beginRead(texture, 0, format, 0, 0, 4, 4, ticket) == GL_NO_ERROR);
+    TEST_ASSERT((glw::counters() - before_read).bytes_read == 0);
+    TEST_ASSERT(transfer.endRead(ticket, read_texels) == GL_NO_ERROR);
+    TEST_ASSERT((glw::counters() - before_read).bytes_read == sizeof(read_texels));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+#define __GLW_ENABLE_DEBUG_OUTPUT
+#include "test.hpp"
+#include "glw_buffer.hpp"
+#include "glw_debug.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+
+    const int write_data[4] = { 0,1,2,3 };
+
+    glw::DebugOutput debug(true, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    glw::Buffer buffer(GL_ARRAY_BUFFER, GL_STATIC_DRAW, sizeof(write_data), NULL, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    // Out of range write raises an error attributed to the buffer.
+    error = buffer.write(sizeof(write_data), sizeof(write_data), write_data);
+    TEST_ASSERT(error == GL_INVALID_VALUE);
+
+    glw::DebugMessage message;
+    bool found = false;
+    while(debug.poll(message)) {
+        if(message.type == GL_DEBUG_TYPE_ERROR) {
+            TEST_ASSERT(message.wrapper == glw::SOURCE_BUFFER);
+            found = true;
+        }
+    }
+    TEST_ASSERT(found);
+    TEST_ASSERT(debug.count(GL_DEBUG_SEVERITY_HIGH, glw::SOURCE_BUFFER) >= 1);
+    TEST_ASSERT(debug.count(GL_DEBUG_SEVERITY_HIGH, glw::SOURCE_TEXTURE) == 0);
+
+    // Performance warnings are queued separately.
+    glDebugMessageInsert(
+        GL_DEBUG_SOURCE_APPLICATION,
+        GL_DEBUG_TYPE_PERFORMANCE,
+        1,
+        GL_DEBUG_SEVERITY_MEDIUM,
+        -1,
+        "stall");
+    TEST_ASSERT(debug.pollPerformance(message));
+    TEST_ASSERT(message.id == 1);
+    TEST_ASSERT(strcmp(message.text, "stall") == 0);
+    TEST_ASSERT(message.wrapper == glw::SOURCE_UNKNOWN);
+    TEST_ASSERT(!debug.pollPerformance(message));
+    TEST_ASSERT(debug.dropped() == 0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "test.hpp"
+#include "glw_framebuffer.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+    const GLint size = 16;
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    const GLint samples = std::min(4, max_samples);
+
+    // Multisampled color and depth, resolved into a texture.
+    glw::Renderbuffer color(GL_RGBA8, size, size, samples, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    glw::Renderbuffer depth(GL_DEPTH_COMPONENT24, size, size, samples, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    glw::Texture2D texture(GL_RGBA8, 1, size, size, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    glw::Framebuffer multisampled(&error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(multisampled.attach(GL_COLOR_ATTACHMENT0, color) == GL_NO_ERROR);
+    TEST_ASSERT(multisampled.attach(GL_DEPTH_ATTACHMENT, depth) == GL_NO_ERROR);
+    TEST_ASSERT(multisampled.status() == GL_FRAMEBUFFER_COMPLETE);
+    TEST_ASSERT(multisampled.width() == size && multisampled.samples() == samples);
+    TEST_ASSERT(multisampled.drawBuffers().size() == 1);
+
+    glw::Framebuffer resolved(&error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(resolved.attach(GL_COLOR_ATTACHMENT0, texture) == GL_NO_ERROR);
+    TEST_ASSERT(resolved.status() == GL_FRAMEBUFFER_COMPLETE);
+
+    // Editing attachments leaves the current binding alone.
+    GLint bound = -1;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound);
+    TEST_ASSERT(bound == 0);
+
+    TEST_ASSERT(multisampled.bind() == GL_NO_ERROR);
+    glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    TEST_ASSERT(multisampled.resolve(resolved) == GL_NO_ERROR);
+
+    // Depth and the samples are not needed after the resolve.
+    const GLenum transient[2] = { GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT };
+    TEST_ASSERT(multisampled.invalidate(transient, 2) == GL_NO_ERROR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glw::ImageFormat format = { GL_UNSIGNED_BYTE, GL_RGBA };
+    GLubyte texel[4] = {0};
+    error = texture.read(0, format, size / 2, size / 2, 1, 1, texel);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(texel[0] == 0 && texel[1] == 255 && texel[2] == 0);
+
+    // Layers of arrays and faces of cube maps.
+    glw::Texture2DArray layers(GL_RGBA8, 1, size, size, 2, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    glw::Framebuffer layered(&error);
+    TEST_ASSERT(layered.attach(GL_COLOR_ATTACHMENT0, layers, 0, 1) == GL_NO_ERROR);
+    TEST_ASSERT(layered.status() == GL_FRAMEBUFFER_COMPLETE);
+    glw::TextureCube cube(GL_RGBA8, 1, size, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(layered.attach(GL_COLOR_ATTACHMENT1, cube, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(layered.status() == GL_FRAMEBUFFER_COMPLETE);
+    TEST_ASSERT(layered.drawBuffers().size() == 2);
+
+    return EXIT_SUCCESS;
+}
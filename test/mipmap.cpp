@@ -0,0 +1,63 @@
+#include "test.hpp"
+#include "glw_mipmap.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+
+    // Box filter, with odd sizes clamping to the last row and column.
+    const GLubyte gray[3 * 3] = {
+        0,   40,  80,
+        120, 160, 200,
+        240, 255, 255, };
+    GLubyte half[1];
+    glw::MipGenerator::downsample(gray, 3, 3, 1, half);
+    TEST_ASSERT(half[0] == 80);
+
+    // The SIMD and scalar RGBA paths agree with each other and across
+    // thread counts.
+    const GLint size = 258;
+    std::vector<GLubyte> image(size * size * 4);
+    for(size_t i = 0; i < image.size(); ++i) {
+        image[i] = (GLubyte)((i * 7919) >> 3);
+    }
+    std::vector<GLubyte> single((size / 2) * (size / 2) * 4);
+    std::vector<GLubyte> threaded(single.size());
+    glw::MipGenerator::downsample(&image[0], size, size, 4, &single[0], glw::MIP_FILTER_BOX, 1);
+    glw::MipGenerator::downsample(&image[0], size, size, 4, &threaded[0], glw::MIP_FILTER_BOX, 4);
+    TEST_ASSERT(single == threaded);
+    for(GLint x = 0; x < size / 2; ++x) {
+        const GLubyte* a = &image[x * 8];
+        const GLubyte* b = &image[size * 4 + x * 8];
+        TEST_ASSERT(single[x * 4 + 1] == (a[1] + a[5] + b[1] + b[5] + 2) / 4);
+    }
+
+    glw::MipGenerator::downsample(&image[0], size, size, 4, &single[0], glw::MIP_FILTER_KAISER, 1);
+    glw::MipGenerator::downsample(&image[0], size, size, 4, &threaded[0], glw::MIP_FILTER_KAISER, 4);
+    TEST_ASSERT(single == threaded);
+
+    // The Kaiser filter preserves constant images.
+    std::vector<GLubyte> constant(16 * 16 * 3, 100);
+    std::vector<GLubyte> filtered(8 * 8 * 3);
+    glw::MipGenerator::downsample(&constant[0], 16, 16, 3, &filtered[0], glw::MIP_FILTER_KAISER);
+    TEST_ASSERT(filtered == std::vector<GLubyte>(8 * 8 * 3, 100));
+
+    // Whole chains upload into immutable textures.
+    glw::ImageFormat format = { GL_UNSIGNED_BYTE, GL_RGBA };
+    glw::Texture2D texture(GL_RGBA8, 0, 8, 8, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(texture.levels() == 4);
+    std::vector<GLubyte> level0(8 * 8 * 4, 200);
+    error = texture.write(0, format, 0,0, 8,8, &level0[0]);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    error = glw::write_mipmaps(texture, format, &level0[0]);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    GLubyte texel[4] = {0};
+    error = texture.read(3, format, 0,0, 1,1, texel);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(texel[0] == 200 && texel[3] == 200);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include "test.hpp"
+#include "glw_pixel_transfer.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+
+    const size_t data_cols = 4;
+    const size_t data_rows = 4;
+    GLubyte write_data[data_cols * data_rows * 4];
+    GLubyte read_data[data_cols * data_rows * 4] = {0};
+    for(size_t i = 0; i < sizeof(write_data); ++i) {
+        write_data[i] = (GLubyte)i;
+    }
+
+    glw::ImageFormat format = { GL_UNSIGNED_BYTE, GL_RGBA };
+
+    glw::Texture2D texture(GL_RGBA, format, data_cols,data_rows, NULL);
+
+    glw::PixelTransfer transfer;
+
+    error = transfer.upload(texture, 0, format, 0,0, data_cols,data_rows, write_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    // Texture reads honour the requested region.
+    error = texture.read(0, format, 1,1, 2,2, read_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(memcmp(read_data + 0, write_data + (1 * data_cols + 1) * 4, 8) == 0);
+    TEST_ASSERT(memcmp(read_data + 8, write_data + (2 * data_cols + 1) * 4, 8) == 0);
+
+    // Reads can outnumber the ring's buffers.
+    for(size_t frame = 0; frame < transfer.buffers() * 2 + 1; ++frame) {
+        write_data[0] = (GLubyte)frame;
+        error = transfer.upload(texture, 0, format, 0,0, data_cols,data_rows, write_data);
+        TEST_ASSERT(error == GL_NO_ERROR);
+
+        size_t ticket;
+        error = transfer.beginRead(texture, 0, format, 0,0, data_cols,data_rows, ticket);
+        TEST_ASSERT(error == GL_NO_ERROR);
+
+        memset(read_data, 0, sizeof(read_data));
+        error = transfer.endRead(ticket, read_data);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(transfer.ready(ticket));
+        TEST_ASSERT(memcmp(write_data, read_data, sizeof(write_data)) == 0);
+
+        // The pack buffer is not left bound for reads to client memory.
+        memset(read_data, 0, sizeof(read_data));
+        error = texture.read(0, format, 0,0, data_cols,data_rows, read_data);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(memcmp(write_data, read_data, sizeof(write_data)) == 0);
+    }
+
+    // Tickets not handed out by the transfer are rejected.
+    TEST_ASSERT(transfer.endRead(transfer.buffers(), read_data) == GL_INVALID_OPERATION);
+    TEST_ASSERT(!transfer.ready(transfer.buffers()));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#ifndef __GLW_ENABLE_PROFILER
+#define __GLW_ENABLE_PROFILER
+#endif
+#include "test.hpp"
+
+#include <algorithm>
+
+// Stand-ins for the query calls of the profiler, which report the queries
+// in test_held as unavailable, as a GPU still busy with them would, and
+// note whether a result of one of them was waited for.
+static std::vector<GLuint> test_held;
+static GLuint test_last_query = 0;
+static bool test_waited = false;
+
+static bool test_is_held(const GLuint id)
+{
+    return std::find(test_held.begin(), test_held.end(), id) != test_held.end();
+}
+
+static void test_query_counter(GLuint id, GLenum target)
+{
+    glQueryCounter(id, target);
+    test_last_query = id;
+}
+
+static void test_get_query_objectuiv(GLuint id, GLenum name, GLuint* result)
+{
+    glGetQueryObjectuiv(id, name, result);
+    if(name == GL_QUERY_RESULT_AVAILABLE && test_is_held(id)) *result = GL_FALSE;
+}
+
+static void test_get_query_objectui64v(GLuint id, GLenum name, GLuint64* result)
+{
+    if(name == GL_QUERY_RESULT && test_is_held(id)) test_waited = true;
+    glGetQueryObjectui64v(id, name, result);
+}
+
+#undef glQueryCounter
+#undef glGetQueryObjectuiv
+#undef glGetQueryObjectui64v
+#define glQueryCounter test_query_counter
+#define glGetQueryObjectuiv test_get_query_objectuiv
+#define glGetQueryObjectui64v test_get_query_objectui64v
+
+#include "glw_buffer.hpp"
+#include "glw_profiler.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+    const GLuint latency = 2;
+    const int frames = 6;
+    const int data[64] = {0};
+
+    glw::Buffer buffer(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW, sizeof(data), NULL, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    glw::Profiler::resetCalls();
+
+    glw::Profiler profiler(latency);
+    for(int i = 0; i < frames; ++i) {
+        TEST_ASSERT(profiler.beginFrame() == GL_NO_ERROR);
+        {
+            glw::Profiler::Scope upload(profiler, "upload");
+            TEST_ASSERT(buffer.write(0, sizeof(data), data) == GL_NO_ERROR);
+            glw::Profiler::Scope clear(profiler, "clear");
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        TEST_ASSERT(profiler.endFrame() == GL_NO_ERROR);
+    }
+    TEST_ASSERT(profiler.frame() == frames);
+    TEST_ASSERT(profiler.end() == GL_INVALID_OPERATION);
+
+    // Frames are collected once latency frames old, and only then.
+    for(size_t i = 0; i < profiler.events().size(); ++i) {
+        TEST_ASSERT(profiler.events()[i].frame + latency < frames);
+    }
+    profiler.finish();
+    TEST_ASSERT(profiler.events().size() == frames * 3);
+
+    const glw::Profiler::Event& frame = profiler.events()[0];
+    const glw::Profiler::Event& upload = profiler.events()[1];
+    const glw::Profiler::Event& clear = profiler.events()[2];
+    TEST_ASSERT(strcmp(frame.name, "Frame") == 0 && frame.depth == 0);
+    TEST_ASSERT(strcmp(upload.name, "upload") == 0 && upload.depth == 1);
+    TEST_ASSERT(strcmp(clear.name, "clear") == 0 && clear.depth == 2);
+    TEST_ASSERT(frame.cpu_begin <= upload.cpu_begin && upload.cpu_end <= frame.cpu_end);
+    TEST_ASSERT(upload.cpu_begin <= clear.cpu_begin && clear.cpu_end <= upload.cpu_end);
+    if(profiler.hasTimer()) {
+        TEST_ASSERT(frame.gpu_begin <= upload.gpu_begin && upload.gpu_end <= frame.gpu_end);
+        TEST_ASSERT(clear.gpu_begin <= clear.gpu_end);
+    }
+
+    const std::vector<glw::Profiler::Summary> summary = profiler.summary();
+    TEST_ASSERT(summary.size() == 3);
+    for(size_t i = 0; i < summary.size(); ++i) {
+        TEST_ASSERT(summary[i].count == frames);
+    }
+
+    const std::string trace = profiler.chromeTrace();
+    TEST_ASSERT(trace.compare(0, 16, "{\"traceEvents\":[") == 0);
+    TEST_ASSERT(trace.find("\"name\":\"upload\",\"ph\":\"X\"") != std::string::npos);
+    TEST_ASSERT(trace.find("\"args\":{\"name\":\"GPU\"}") != std::string::npos);
+
+    // Wrapper methods are counted by name.
+    const std::vector<glw::Profiler::Calls> calls = glw::Profiler::calls();
+    bool found = false;
+    for(size_t i = 0; i < calls.size(); ++i) {
+        if(calls[i].name == "Buffer::write") {
+            TEST_ASSERT(calls[i].calls == frames);
+            found = true;
+        }
+    }
+    TEST_ASSERT(found);
+    glw::Profiler::resetCalls();
+    TEST_ASSERT(glw::Profiler::calls().empty());
+
+    // A frame is not collected before its last timestamp, the end of the
+    // frame scope written by endFrame(), has a result, even if those of the
+    // scopes within have.
+    glw::Profiler pending(0);
+    if(pending.hasTimer()) {
+        TEST_ASSERT(pending.beginFrame() == GL_NO_ERROR);
+        {
+            glw::Profiler::Scope inner(pending, "inner");
+        }
+        TEST_ASSERT(pending.endFrame() == GL_NO_ERROR);
+        glFinish();
+        test_held.push_back(test_last_query);
+        pending.collect();
+        TEST_ASSERT(pending.events().empty());
+        TEST_ASSERT(!test_waited);
+        test_held.clear();
+        pending.collect();
+        TEST_ASSERT(pending.events().size() == 2);
+    }
+
+    return EXIT_SUCCESS;
+}
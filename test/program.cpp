@@ -1,4 +1,5 @@
 #include "test.hpp"
+#include "glw_buffer.hpp"
 #include "glw_program.hpp"
 
 int main()
@@ -22,6 +23,7 @@ int main()
     glGenBuffers(1, &buffer);
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
     glBufferData(GL_ARRAY_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+    glw::StateCache::current().invalidate();
 
     glw::Program::Shaders shaders = {
         { GL_VERTEX_SHADER, vsource },
@@ -52,6 +54,232 @@ int main()
     error = program.execute(GL_TRIANGLES, 0, 3);
     TEST_ASSERT(error == GL_NO_ERROR);
 
+    // Unchanged values are not uploaded again.
+    TEST_ASSERT(program.uniformStats().uploads == 1);
+    program.resetUniformStats();
+    error = program.setUniform("u_time", 0.f);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    error = program.execute(GL_TRIANGLES, 0, 3);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(program.uniformStats().uploads == 0);
+    TEST_ASSERT(program.uniformStats().skipped == 1);
+
+    glw::Program::UniformHandle u_time = program.uniformHandle("u_time");
+    TEST_ASSERT(u_time.valid());
+    TEST_ASSERT(!program.uniformHandle("u_missing").valid());
+    TEST_ASSERT(program.setUniform(u_time, 1.f) == GL_NO_ERROR);
+
+    glw::Program::AttributeHandle v_position = program.attributeHandle("v_position");
+    TEST_ASSERT(v_position.valid());
+    TEST_ASSERT(program.setAttribute(v_position, buffer) == GL_NO_ERROR);
+
+    error = program.execute(GL_TRIANGLES, 0, 3);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(program.uniformStats().uploads == 1);
+
+    // One vertex array object per distinct attribute layout.
+    TEST_ASSERT(program.vertexArrays() == 1);
+    TEST_ASSERT(program.setAttribute(v_position, buffer, 8, 8) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 2) == GL_NO_ERROR);
+    TEST_ASSERT(program.vertexArrays() == 2);
+    TEST_ASSERT(program.setAttribute(v_position, buffer) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(program.vertexArrays() == 2);
+
+    // Offsets changing every draw do not grow the cache without bound.
+    for(GLuint offset = 0; offset < 100; ++offset) {
+        TEST_ASSERT(program.setAttribute(v_position, buffer, 8, offset * 4) == GL_NO_ERROR);
+        TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 1) == GL_NO_ERROR);
+        TEST_ASSERT(program.vertexArrays() <= glw::Program::max_vertex_arrays);
+    }
+    TEST_ASSERT(program.vertexArrays() == glw::Program::max_vertex_arrays);
+    TEST_ASSERT(program.setAttribute(v_position, buffer) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+
+    // Deleting a buffer drops the cached vertex arrays, which could refer
+    // to it by a name given to a new buffer since.
+    {
+        glw::Buffer deleted(GL_ARRAY_BUFFER, GL_STATIC_DRAW, sizeof(data), data, &error);
+        TEST_ASSERT(error == GL_NO_ERROR);
+    }
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(program.vertexArrays() == 1);
+
+    // Names longer than 32 characters and array shorthands.
+    const char* lsource = 
+        "#version 330\n"
+        "in vec2 v_position_with_a_name_longer_than_thirty_two;"
+        "uniform float u_offsets[4];"
+        "void main() { gl_Position = vec4(v_position_with_a_name_longer_than_thirty_two, u_offsets[3], 1); }";
+    glw::Program::Shaders long_shaders = {
+        { GL_VERTEX_SHADER, lsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program long_program(long_shaders, &error);
+    TEST_ASSERT(long_program.build() == GL_NO_ERROR);
+    TEST_ASSERT(long_program.attributeHandle("v_position_with_a_name_longer_than_thirty_two").valid());
+    TEST_ASSERT(long_program.uniformHandle("u_offsets").index == long_program.uniformHandle("u_offsets[0]").index);
+    float offsets[4] = { 0, 0, 0, 0 };
+    TEST_ASSERT(long_program.setUniform("u_offsets", offsets[0], 4) == GL_NO_ERROR);
+    glUseProgram(long_program());
+    TEST_ASSERT(long_program.prepare() == GL_NO_ERROR);
+    TEST_ASSERT(long_program.uniformStats().uploads == 1);
+
+    // Only the changed element is uploaded.
+    offsets[2] = 1;
+    TEST_ASSERT(long_program.setUniform("u_offsets", offsets[0], 4) == GL_NO_ERROR);
+    TEST_ASSERT(long_program.prepare() == GL_NO_ERROR);
+    TEST_ASSERT(long_program.uniformStats().uploads == 2);
+    float uploaded[4];
+    glGetUniformfv(long_program(), long_program.uniforms()[0].location, uploaded);
+    glGetUniformfv(long_program(), long_program.uniforms()[0].location + 2, uploaded + 2);
+    TEST_ASSERT(uploaded[0] == 0 && uploaded[2] == 1);
+    TEST_ASSERT(memcmp(long_program.uniformData(long_program.uniforms()[0]), offsets, sizeof(offsets)) == 0);
+    glw::StateCache::current().invalidate();
+
+    // Unsigned and boolean uniforms.
+    const char* usource =
+        "#version 330\n"
+        "in vec2 v_position;"
+        "uniform uvec2 u_mask;"
+        "uniform bool u_flag;"
+        "void main() { gl_Position = vec4(v_position, float(u_mask.y) * float(u_flag), 1); }";
+    glw::Program::Shaders unsigned_shaders = {
+        { GL_VERTEX_SHADER, usource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program unsigned_program(unsigned_shaders, &error);
+    TEST_ASSERT(unsigned_program.build() == GL_NO_ERROR);
+    const GLuint mask[2] = { 1, 7 };
+    const GLint flag = 1;
+    TEST_ASSERT(unsigned_program.setUniform("u_mask", mask) == GL_NO_ERROR);
+    TEST_ASSERT(unsigned_program.setUniform("u_flag", flag) == GL_NO_ERROR);
+    glUseProgram(unsigned_program());
+    TEST_ASSERT(unsigned_program.prepare() == GL_NO_ERROR);
+    GLuint uploaded_mask[2] = { 0, 0 };
+    GLint uploaded_flag = 0;
+    glGetUniformuiv(unsigned_program(), glGetUniformLocation(unsigned_program(), "u_mask"), uploaded_mask);
+    glGetUniformiv(unsigned_program(), glGetUniformLocation(unsigned_program(), "u_flag"), &uploaded_flag);
+    TEST_ASSERT(uploaded_mask[1] == 7 && uploaded_flag == 1);
+    glw::StateCache::current().invalidate();
+
+    // A uniform that fails to upload stays dirty, and is retried.
+    if(glw::has_version(4, 0)) {
+        const char* dsource =
+            "#version 400\n"
+            "in vec2 v_position;"
+            "uniform double u_double;"
+            "void main() { gl_Position = vec4(v_position, float(u_double), 1); }";
+        glw::Program::Shaders double_shaders = {
+            { GL_VERTEX_SHADER, dsource },
+            { GL_FRAGMENT_SHADER, fsource } };
+        glw::Program double_program(double_shaders, &error);
+        TEST_ASSERT(double_program.build() == GL_NO_ERROR);
+        TEST_ASSERT(double_program.setUniform("u_double", 1.0) == GL_NO_ERROR);
+        glUseProgram(double_program());
+        TEST_ASSERT(double_program.prepare() == GL_INVALID_OPERATION);
+        TEST_ASSERT(double_program.prepare() == GL_INVALID_OPERATION);
+        glw::StateCache::current().invalidate();
+    }
+
+    // Drawing again with the same program skips glUseProgram.
+    glw::StateCache::current().resetStats();
+    TEST_ASSERT(long_program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(long_program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(glw::StateCache::current().stats().hits == 2);
+
+    // Batch builds submit every program before checking any.
+    glw::set_compiler_threads(0xFFFFFFFF);
+    glw::Program batch_a(shaders), batch_b(long_shaders);
+    glw::Program* batch[2] = { &batch_a, &batch_b };
+    TEST_ASSERT(glw::build_programs(batch, 2) == GL_NO_ERROR);
+    TEST_ASSERT(batch_b.uniformHandle("u_offsets").valid());
+
+    TEST_ASSERT(batch_a.submit() == GL_NO_ERROR);
+    while(!batch_a.isReady()) {}
+    TEST_ASSERT(batch_a.finish() == GL_NO_ERROR);
+    TEST_ASSERT(batch_a.isReady());
+    TEST_ASSERT(batch_a.attributeHandle("v_position").valid());
+
+    // Instanced, multi and indirect draws.
+    const char* isource = 
+        "#version 330\n"
+        "in vec2 v_position;"
+        "in vec2 v_offset;"
+        "void main() { gl_Position = vec4(v_position + v_offset, 0, 1); }";
+    glw::Program::Shaders instanced_shaders = {
+        { GL_VERTEX_SHADER, isource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program instanced(instanced_shaders);
+    TEST_ASSERT(instanced.build() == GL_NO_ERROR);
+
+    const GLuint indices[3] = { 0, 1, 2 };
+    const GLuint commands[2][5] = { { 3, 2, 0, 0, 0 }, { 3, 1, 0, 0, 0 } };
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffers[1]);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(commands), commands, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glw::StateCache::current().invalidate();
+
+    TEST_ASSERT(instanced.setAttribute("v_position", buffer, 0, 0) == GL_NO_ERROR);
+    TEST_ASSERT(instanced.setAttribute("v_offset", buffer, 0, 0, 1) == GL_NO_ERROR);
+    TEST_ASSERT(instanced.executeInstanced(GL_TRIANGLES, 0, 3, 2) == GL_NO_ERROR);
+    GLint divisor = 0;
+    glGetVertexAttribiv(instanced.attributes()[instanced.attributeHandle("v_offset").index].location, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+    TEST_ASSERT(divisor == 1);
+    TEST_ASSERT(instanced.executeInstanced(GL_TRIANGLES, 3, GL_UNSIGNED_INT, buffers[0], 2, 0, 0) == GL_NO_ERROR);
+
+    const GLint firsts[2] = { 0, 1 };
+    const GLsizei counts[2] = { 2, 2 };
+    const void* element_offsets[2] = { (const void*)0, (const void*)sizeof(GLuint) };
+    TEST_ASSERT(instanced.executeMulti(GL_LINES, firsts, counts, 2) == GL_NO_ERROR);
+    TEST_ASSERT(instanced.executeMulti(GL_LINES, counts, GL_UNSIGNED_INT, buffers[0], element_offsets, 2) == GL_NO_ERROR);
+
+    TEST_ASSERT(instanced.executeIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, buffers[0], buffers[1]) == GL_NO_ERROR);
+    TEST_ASSERT(instanced.executeIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, buffers[0], buffers[1], 0, 2) == GL_NO_ERROR);
+
+    // Samplers of any texture type bind their texture on draw.
+    const char* ssource = 
+        "#version 330\n"
+        "uniform sampler2DArray u_layers;"
+        "uniform samplerCube u_sky;"
+        "uniform usampler3D u_volume;"
+        "out vec4 f_color;"
+        "void main() { f_color = texture(u_layers, vec3(0)) + texture(u_sky, vec3(1)) + vec4(texture(u_volume, vec3(0))); }";
+    glw::Program::Shaders sampler_shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, ssource } };
+    glw::Program sampled(sampler_shaders, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(sampled.build() == GL_NO_ERROR);
+
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textures[0]);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textures[1]);
+    glBindTexture(GL_TEXTURE_3D, textures[2]);
+    glw::StateCache::current().invalidate();
+
+    TEST_ASSERT(sampled.setUniform("u_time", 0.f) == GL_NO_ERROR);
+    TEST_ASSERT(sampled.setAttribute("v_position", buffer) == GL_NO_ERROR);
+    TEST_ASSERT(sampled.setSampler("u_layers", 1, textures[0]) == GL_NO_ERROR);
+    TEST_ASSERT(sampled.setSampler("u_sky", 2, textures[1]) == GL_NO_ERROR);
+    TEST_ASSERT(sampled.setSampler("u_volume", 3, textures[2]) == GL_NO_ERROR);
+    TEST_ASSERT(sampled.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+
+    const GLenum bindings[3] = { GL_TEXTURE_BINDING_2D_ARRAY, GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_3D };
+    const char* names[3] = { "u_layers", "u_sky", "u_volume" };
+    for(int i = 0; i < 3; ++i) {
+        GLint bound = 0;
+        GLint unit = 0;
+        glActiveTexture(GL_TEXTURE1 + i);
+        glGetIntegerv(bindings[i], &bound);
+        glGetUniformiv(sampled.id(), glGetUniformLocation(sampled.id(), names[i]), &unit);
+        TEST_ASSERT(bound == (GLint)textures[i]);
+        TEST_ASSERT(unit == 1 + i);
+    }
+
     return EXIT_SUCCESS;
 }
 
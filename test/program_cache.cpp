@@ -0,0 +1,58 @@
+#include "test.hpp"
+#include "glw_program_cache.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    const char* vsource = 
+        "#version 330\n"
+        "in vec2 v_position;"
+        "uniform float u_time;"
+        "void main() { gl_Position = vec4(v_position, u_time, 1); }";
+    const char* fsource = 
+        "#version 330\n"
+        "out vec4 f_color;"
+        "void main() { f_color = vec4(1,0,0,1); }";
+
+    glw::Program::Shaders shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+
+    char directory[] = "/tmp/glw_program_cache_XXXXXX";
+    TEST_ASSERT(mkdtemp(directory) != NULL);
+
+    glw::ProgramCache cache(directory);
+
+    // The first build compiles and stores the binary.
+    glw::Program program_a(shaders);
+    TEST_ASSERT(cache.build(program_a) == GL_NO_ERROR);
+    TEST_ASSERT(cache.stats().misses == 1);
+
+    // Later builds of the same sources restore it.
+    glw::Program program_b(shaders);
+    TEST_ASSERT(cache.build(program_b) == GL_NO_ERROR);
+    TEST_ASSERT(cache.stats().hits == 1);
+    TEST_ASSERT(program_b.getInfo<GL_LINK_STATUS>() == GL_TRUE);
+    TEST_ASSERT(program_b.attributeHandle("v_position").valid());
+    TEST_ASSERT(program_b.uniformHandle("u_time").valid());
+
+    // Entries the driver rejects fall back to compiling.
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%016llx.bin", directory, (unsigned long long)cache.key(program_a));
+    FILE* stream = fopen(path, "r+b");
+    TEST_ASSERT(stream != NULL);
+    fseek(stream, 32, SEEK_SET);
+    for(int i = 0; i < 64; ++i) fputc(0xff, stream);
+    fclose(stream);
+
+    glw::Program program_c(shaders);
+    TEST_ASSERT(cache.build(program_c) == GL_NO_ERROR);
+    TEST_ASSERT(cache.stats().rejected == 1);
+    TEST_ASSERT(program_c.uniformHandle("u_time").valid());
+
+    remove(path);
+    rmdir(directory);
+
+    return EXIT_SUCCESS;
+}
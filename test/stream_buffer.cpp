@@ -0,0 +1,83 @@
+#include "test.hpp"
+#include "glw_stream_buffer.hpp"
+
+static void test_stream(const bool persistent)
+{
+    GLuint error = GL_NO_ERROR;
+
+    const size_t frames = 3;
+    const float write_data[4] = { 1, 2, 3, 4 };
+    float read_data[4];
+
+    glw::StreamBuffer stream(GL_ARRAY_BUFFER, 64, frames, persistent, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(stream.persistent() == persistent);
+
+    GLintptr offsets[frames * 2];
+    for(size_t frame = 0; frame < frames * 2; ++frame) {
+        void* mem = stream.allocate(sizeof(write_data), offsets[frame], sizeof(write_data));
+        TEST_ASSERT(mem != NULL);
+        TEST_ASSERT(offsets[frame] % sizeof(write_data) == 0);
+        memcpy(mem, write_data, sizeof(write_data));
+        TEST_ASSERT(stream.commit() == GL_NO_ERROR);
+
+        glGetNamedBufferSubData(stream.id(), offsets[frame], sizeof(read_data), read_data);
+        TEST_ASSERT(memcmp(write_data, read_data, sizeof(write_data)) == 0);
+
+        TEST_ASSERT(stream.advance() == GL_NO_ERROR);
+    }
+
+    if(persistent) {
+        // Each frame writes to its own region and the ring wraps around.
+        TEST_ASSERT(offsets[0] == 0);
+        TEST_ASSERT(offsets[1] == 64);
+        TEST_ASSERT(offsets[2] == 128);
+        TEST_ASSERT(offsets[3] == 0);
+
+        // A region holds at most region_size bytes per frame.
+        GLintptr offset;
+        TEST_ASSERT(stream.allocate(48, offset) != NULL);
+        TEST_ASSERT(stream.allocate(32, offset) == NULL);
+    }
+}
+
+// Vertices of a 12-byte stride are drawn from offset / stride, which must
+// hold in every region, although the region size is not a multiple of it.
+static void test_stride(const bool persistent)
+{
+    GLuint error = GL_NO_ERROR;
+
+    const size_t stride = 12;
+    const float vertex[3] = { 1, 2, 3 };
+    float read_data[3];
+
+    glw::StreamBuffer stream(GL_ARRAY_BUFFER, 64 * 1024, 3, persistent, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    for(size_t frame = 0; frame < 3; ++frame) {
+        for(size_t i = 0; i < 2; ++i) {
+            GLintptr offset;
+            void* mem = stream.allocate(sizeof(vertex), offset, stride);
+            TEST_ASSERT(mem != NULL);
+            TEST_ASSERT(offset % stride == 0);
+            memcpy(mem, vertex, sizeof(vertex));
+            TEST_ASSERT(stream.commit() == GL_NO_ERROR);
+
+            glGetNamedBufferSubData(stream.id(), offset, sizeof(read_data), read_data);
+            TEST_ASSERT(memcmp(vertex, read_data, sizeof(vertex)) == 0);
+        }
+        TEST_ASSERT(stream.advance() == GL_NO_ERROR);
+    }
+}
+
+int main()
+{
+    TEST_INIT();
+
+    test_stream(true);
+    test_stream(false);
+    test_stride(true);
+    test_stride(false);
+
+    return EXIT_SUCCESS;
+}
@@ -1,26 +1,176 @@
 #ifndef __GLW_TEST_HPP
 #define __GLW_TEST_HPP
 
+// Tests create their context through one of the backends compiled in:
+//
+//   __GLW_TEST_EGL     surfaceless EGL, e.g. Mesa llvmpipe; link -lEGL
+//   __GLW_TEST_OSMESA  off-screen Mesa; link -lOSMesa
+//   __GLW_TEST_GLFW    a GLFW window; link -lglfw
+//
+// GLFW is the default when none is defined. With several compiled in, the
+// GLW_TEST_CONTEXT environment variable picks one by name ("egl",
+// "osmesa" or "glfw"); otherwise they are tried in that order.
+#if !defined(__GLW_TEST_EGL) && !defined(__GLW_TEST_OSMESA) && !defined(__GLW_TEST_GLFW)
+#define __GLW_TEST_GLFW
+#endif
+
 #include <GL/glew.h>
+#ifdef __GLW_TEST_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#ifdef __GLW_TEST_OSMESA
+#include <GL/osmesa.h>
+#endif
+#ifdef __GLW_TEST_GLFW
 #include <GLFW/glfw3.h>
+#endif
 
 #include <iostream>
 #include <cstdlib>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
+#include <vector>
 
 #define TEST_INIT test_init
 
 #define TEST_ASSERT(Expr) assert(Expr)
 
-void test_init()
+static const int test_width = 640;
+static const int test_height = 480;
+
+// Compatibility profile versions to try, newest first.
+static const int test_versions[][2] = { {4, 6}, {4, 5}, {4, 3}, {3, 3} };
+
+#ifdef __GLW_TEST_EGL
+bool test_init_egl()
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(get_platform_display) {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if(display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+
+    // A pbuffer gives the tests a default framebuffer to draw to.
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE };
+    EGLConfig config;
+    EGLint configs = 0;
+    if(!eglChooseConfig(display, config_attributes, &config, 1, &configs) || configs < 1) {
+        return false;
+    }
+    const EGLint surface_attributes[] = { EGL_WIDTH, test_width, EGL_HEIGHT, test_height, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attributes);
+    if(surface == EGL_NO_SURFACE) {
+        return false;
+    }
+
+    EGLContext context = EGL_NO_CONTEXT;
+    for(size_t i = 0; i < sizeof(test_versions) / sizeof(test_versions[0]) && context == EGL_NO_CONTEXT; ++i) {
+        const EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, test_versions[i][0],
+            EGL_CONTEXT_MINOR_VERSION, test_versions[i][1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+            EGL_NONE };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    }
+    return context != EGL_NO_CONTEXT && eglMakeCurrent(display, surface, surface, context);
+}
+#endif
+
+#ifdef __GLW_TEST_OSMESA
+bool test_init_osmesa()
+{
+    // The color buffer must outlive the context, which lives until exit.
+    static std::vector<GLubyte> color(test_width * test_height * 4);
+    OSMesaContext context = NULL;
+    for(size_t i = 0; i < sizeof(test_versions) / sizeof(test_versions[0]) && !context; ++i) {
+        const int attributes[] = {
+            OSMESA_FORMAT, OSMESA_RGBA,
+            OSMESA_DEPTH_BITS, 24,
+            OSMESA_PROFILE, OSMESA_COMPAT_PROFILE,
+            OSMESA_CONTEXT_MAJOR_VERSION, test_versions[i][0],
+            OSMESA_CONTEXT_MINOR_VERSION, test_versions[i][1],
+            0 };
+        context = OSMesaCreateContextAttribs(attributes, NULL);
+    }
+    return context && OSMesaMakeCurrent(context, &color[0], GL_UNSIGNED_BYTE, test_width, test_height);
+}
+#endif
+
+#ifdef __GLW_TEST_GLFW
+bool test_init_glfw()
 {
     GLFWwindow* window;
-    if(!glfwInit()) exit(EXIT_FAILURE);
-    if(!(window = glfwCreateWindow(640, 480, "test", NULL, NULL))) exit(EXIT_FAILURE);
+    if(!glfwInit()) return false;
+    if(!(window = glfwCreateWindow(test_width, test_height, "test", NULL, NULL))) return false;
     glfwMakeContextCurrent(window);
-    if(glewInit() != GLEW_OK) exit(EXIT_FAILURE);
+    return true;
+}
+#endif
+
+// Name of the backend test_init() created the context with.
+const char*& test_backend()
+{
+    static const char* backend = NULL;
+    return backend;
 }
 
+void test_init()
+{
+    struct Backend
+    {
+        const char* name;
+        bool (*init)();
+    };
+    const Backend backends[] = {
+#ifdef __GLW_TEST_EGL
+        { "egl", test_init_egl },
 #endif
+#ifdef __GLW_TEST_OSMESA
+        { "osmesa", test_init_osmesa },
+#endif
+#ifdef __GLW_TEST_GLFW
+        { "glfw", test_init_glfw },
+#endif
+    };
+    const char* requested = getenv("GLW_TEST_CONTEXT");
 
+    for(size_t i = 0; i < sizeof(backends) / sizeof(backends[0]) && !test_backend(); ++i) {
+        if(requested && *requested && strcmp(requested, backends[i].name) != 0) continue;
+        if(backends[i].init()) {
+            test_backend() = backends[i].name;
+        } else {
+            fprintf(stderr, "test: no %s context\n", backends[i].name);
+        }
+    }
+    if(!test_backend()) exit(EXIT_FAILURE);
+
+    // GLEW 2.1 and later load the GL functions before failing to find a
+    // GLX display, which headless contexts have none of.
+    glewExperimental = GL_TRUE;
+    const GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if(result != GLEW_OK && result != GLEW_ERROR_NO_GLX_DISPLAY) exit(EXIT_FAILURE);
+#else
+    if(result != GLEW_OK) exit(EXIT_FAILURE);
+#endif
+}
+
+#endif
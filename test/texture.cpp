@@ -37,6 +37,61 @@ int main()
 
     TEST_ASSERT(memcmp(write_data, read_data, sizeof(write_data)) == 0);
 
+    // Mutable storage has a single level.
+    TEST_ASSERT(texture.levels() == 1);
+    TEST_ASSERT(texture.generateMipmaps() == GL_INVALID_OPERATION);
+
+    // Immutable storage with a full chain, filled by the driver.
+    glw::Texture2D mipmapped(GL_RGBA8, 0, data_cols,data_rows, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(mipmapped.levels() == 3);
+    TEST_ASSERT(mipmapped.getInfo<GL_TEXTURE_WIDTH>(2) == 1);
+
+    error = mipmapped.write(0, format, 0,0, data_cols,data_rows, write_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    error = mipmapped.generateMipmaps();
+    TEST_ASSERT(error == GL_NO_ERROR);
+
+    GLubyte texel[4] = {0};
+    error = mipmapped.read(2, format, 0,0, 1,1, texel);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(texel[3] == 255);
+
+    // Arrays and 3D textures address images by a third coordinate.
+    glw::Texture2DArray layers(GL_RGBA8, 1, data_cols,data_rows, 3, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(layers.layers() == 3);
+    error = layers.write(0, format, 0,0,2, data_cols,data_rows,1, write_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    memset(read_data, 0, sizeof(read_data));
+    error = layers.read(0, format, 0,0,2, data_cols,data_rows,1, read_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(memcmp(write_data, read_data, sizeof(write_data)) == 0);
+
+    glw::Texture3D volume(GL_RGBA8, 0, data_cols,data_rows, 2, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(volume.levels() == 3);
+    error = volume.write(0, format, 0,0,0, data_cols,2,2, write_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    memset(read_data, 0, sizeof(read_data));
+    error = volume.read(0, format, 0,0,1, data_cols,2,1, read_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(memcmp(write_data + data_cols * 2 * 4, read_data, data_cols * 2 * 4) == 0);
+
+    // Cube maps are written and read a face at a time.
+    glw::TextureCube cube(GL_RGBA8, 0, data_cols, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(cube.levels() == 3);
+    TEST_ASSERT(cube.getInfo<GL_TEXTURE_WIDTH>(1) == 2);
+    for(GLint face = 0; face < 6; ++face) {
+        error = cube.write(0, face, format, 0,0, data_cols,data_rows, write_data);
+        TEST_ASSERT(error == GL_NO_ERROR);
+    }
+    memset(read_data, 0, sizeof(read_data));
+    error = cube.read(0, 4, format, 0,0, data_cols,data_rows, read_data);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(memcmp(write_data, read_data, sizeof(write_data)) == 0);
+
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,122 @@
+#include "test.hpp"
+#include "glw_texture_file.hpp"
+
+static void write_file(const char* path, const std::vector<GLubyte>& contents)
+{
+    FILE* stream = fopen(path, "wb");
+    TEST_ASSERT(stream != NULL);
+    fwrite(&contents[0], contents.size(), 1, stream);
+    fclose(stream);
+}
+
+static void put32(std::vector<GLubyte>& contents, const size_t offset, const GLuint value)
+{
+    if(contents.size() < offset + 4) contents.resize(offset + 4, 0);
+    for(int i = 0; i < 4; ++i) contents[offset + i] = (GLubyte)(value >> (i * 8));
+}
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+    char directory[] = "/tmp/glw_texture_file_XXXXXX";
+    TEST_ASSERT(mkdtemp(directory) != NULL);
+    const std::string dds_path = std::string(directory) + "/red.dds";
+    const std::string ktx_path = std::string(directory) + "/green.ktx";
+    const std::string bad_path = std::string(directory) + "/bad.dds";
+
+    // An 8x8 DXT1 image with 2 levels of solid red: both endpoints 0xf800
+    // and all indices 0.
+    std::vector<GLubyte> dds(128, 0);
+    memcpy(&dds[0], "DDS ", 4);
+    put32(dds, 4, 124);
+    put32(dds, 12, 8);
+    put32(dds, 16, 8);
+    put32(dds, 28, 2);
+    put32(dds, 76, 32);
+    put32(dds, 80, 0x4);
+    memcpy(&dds[84], "DXT1", 4);
+    const GLubyte block[8] = { 0x00, 0xf8, 0x00, 0xf8, 0, 0, 0, 0 };
+    for(int i = 0; i < 4 + 1; ++i) dds.insert(dds.end(), block, block + 8);
+    write_file(dds_path.c_str(), dds);
+
+    // A 2x2 RGBA8 image with 1 level of solid green.
+    static const GLubyte ktx_identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+    std::vector<GLubyte> ktx(ktx_identifier, ktx_identifier + 12);
+    put32(ktx, 12, 0x04030201);
+    put32(ktx, 16, GL_UNSIGNED_BYTE);
+    put32(ktx, 20, 1);
+    put32(ktx, 24, GL_RGBA);
+    put32(ktx, 28, GL_RGBA8);
+    put32(ktx, 32, GL_RGBA);
+    put32(ktx, 36, 2);
+    put32(ktx, 40, 2);
+    put32(ktx, 52, 1);
+    put32(ktx, 56, 1);
+    put32(ktx, 60, 0);
+    put32(ktx, 64, 16);
+    for(int i = 0; i < 4; ++i) {
+        const GLubyte green[4] = { 0, 255, 0, 255 };
+        ktx.insert(ktx.end(), green, green + 4);
+    }
+    write_file(ktx_path.c_str(), ktx);
+
+    // Truncated level data.
+    dds.resize(dds.size() - 8);
+    write_file(bad_path.c_str(), dds);
+
+    glw::ImageFormat format = { GL_UNSIGNED_BYTE, GL_RGBA };
+    GLubyte texel[4] = {0};
+
+    if(glw::has_compressed_format(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)) {
+        glw::TextureFile file(dds_path, &error);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(file.compressed());
+        TEST_ASSERT(file.internalFormat() == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+        TEST_ASSERT(file.width() == 8 && file.height() == 8 && file.levels() == 2);
+        TEST_ASSERT(file.level(1).size == glw::sizeof_compressed_image(file.internalFormat(), 4, 4));
+
+        glw::Texture2D texture(file.internalFormat(), file.levels(), file.width(), file.height(), &error);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        error = file.upload(texture);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(texture.getInfo<GL_TEXTURE_COMPRESSED>(1) == GL_TRUE);
+
+        // Compressed levels are read back in whole blocks.
+        GLubyte level[4 * 4 * 4] = {0};
+        error = texture.read(1, format, 0,0, 4,4, level);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(level[0] == 255 && level[1] == 0 && level[2] == 0);
+    }
+
+    {
+        glw::TextureFile file(ktx_path, &error);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(!file.compressed());
+        TEST_ASSERT(file.internalFormat() == GL_RGBA8);
+        TEST_ASSERT(file.width() == 2 && file.height() == 2 && file.levels() == 1);
+
+        glw::Texture2D texture(file.internalFormat(), file.levels(), file.width(), file.height(), &error);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        error = file.upload(texture);
+        TEST_ASSERT(error == GL_NO_ERROR);
+
+        error = texture.read(0, format, 1,1, 1,1, texel);
+        TEST_ASSERT(error == GL_NO_ERROR);
+        TEST_ASSERT(texel[0] == 0 && texel[1] == 255);
+    }
+
+    {
+        glw::TextureFile file(bad_path, &error);
+        TEST_ASSERT(error == GL_INVALID_OPERATION);
+        TEST_ASSERT(!file.valid());
+    }
+
+    remove(dds_path.c_str());
+    remove(ktx_path.c_str());
+    remove(bad_path.c_str());
+    rmdir(directory);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include "test.hpp"
+#include "glw_uniform_block.hpp"
+
+int main()
+{
+    TEST_INIT();
+
+    GLuint error = GL_NO_ERROR;
+
+    const char* vsource = 
+        "#version 330\n"
+        "layout(std140) uniform Camera { mat4 view; mat3 normal; vec3 light; float scale[3]; };"
+        "in vec2 v_position;"
+        "void main() { gl_Position = view * vec4(normal * light * scale[2], 1) + vec4(v_position, 0, 0); }";
+    const char* fsource = 
+        "#version 330\n"
+        "layout(std140) uniform Camera { mat4 view; mat3 normal; vec3 light; float scale[3]; };"
+        "out vec4 f_color;"
+        "void main() { f_color = vec4(light, scale[0]); }";
+
+    glw::Program::Shaders shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+
+    glw::Program program_a(shaders), program_b(shaders);
+    TEST_ASSERT(program_a.build() == GL_NO_ERROR);
+    TEST_ASSERT(program_b.build() == GL_NO_ERROR);
+
+    // std140 layout is reflected.
+    const glw::BlockLayout* layout = program_a.block("Camera");
+    TEST_ASSERT(layout != NULL);
+    TEST_ASSERT(layout->members.size() == 4);
+    TEST_ASSERT(layout->size == 64 + 48 + 16 + 48);
+
+    glw::UniformBlock camera(*layout, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    TEST_ASSERT(camera.memberHandle("scale").valid());
+    TEST_ASSERT(!camera.memberHandle("missing").valid());
+
+    const float view[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+    const float normal[9] = { 1,2,3, 4,5,6, 7,8,9 };
+    const float light[3] = { 1, 2, 3 };
+    const float scale[3] = { 4, 5, 6 };
+    TEST_ASSERT(camera.set("view", view[0], 16) == GL_NO_ERROR);
+    TEST_ASSERT(camera.set("normal", normal[0], 9) == GL_NO_ERROR);
+    TEST_ASSERT(camera.set("light", light[0], 3) == GL_NO_ERROR);
+    TEST_ASSERT(camera.set("scale", scale[0], 3) == GL_NO_ERROR);
+    TEST_ASSERT(camera.set("light", scale[0], 4) != GL_NO_ERROR);
+
+    // One buffer, bound once, serves both programs.
+    TEST_ASSERT(program_a.bindBlock("Camera", 3) == GL_NO_ERROR);
+    TEST_ASSERT(program_b.bindBlock("Camera", 3) == GL_NO_ERROR);
+    TEST_ASSERT(program_a.bindBlock("Missing", 3) != GL_NO_ERROR);
+    TEST_ASSERT(camera.bind(3) == GL_NO_ERROR);
+    GLint bound = 0;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, 3, &bound);
+    TEST_ASSERT(bound == (GLint)camera.id());
+    glGetActiveUniformBlockiv(program_b(), layout->index, GL_UNIFORM_BLOCK_BINDING, &bound);
+    TEST_ASSERT(bound == 3);
+
+    glw::StateCache::current().resetStats();
+    TEST_ASSERT(camera.bind(3) == GL_NO_ERROR);
+    TEST_ASSERT(glw::StateCache::current().stats().hits == 1);
+
+    // Values land at their std140 offsets and strides.
+    float data[44];
+    TEST_ASSERT(camera.buffer().read(0, sizeof(data), data) == GL_NO_ERROR);
+    TEST_ASSERT(memcmp(data, view, sizeof(view)) == 0);
+    TEST_ASSERT(data[16] == 1 && data[17] == 2 && data[18] == 3);
+    TEST_ASSERT(data[20] == 4 && data[24] == 7 && data[26] == 9);
+    TEST_ASSERT(data[28] == 1 && data[29] == 2 && data[30] == 3);
+    TEST_ASSERT(data[32] == 4 && data[36] == 5 && data[40] == 6);
+
+    // Booleans, unsigned vectors, non-square and row-major matrices.
+    const char* msource =
+        "#version 330\n"
+        "layout(std140) uniform Material { bool lit; uvec2 mask; mat2x4 skew; layout(row_major) mat4 r; layout(row_major) mat2x3 q; };"
+        "in vec2 v_position;"
+        "void main() { gl_Position = r * skew * vec2(float(lit), float(mask.y)) + vec4(q * v_position, 0); }";
+    glw::Program::Shaders material_shaders = {
+        { GL_VERTEX_SHADER, msource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program material_program(material_shaders);
+    TEST_ASSERT(material_program.build() == GL_NO_ERROR);
+    const glw::BlockLayout* material_layout = material_program.block("Material");
+    TEST_ASSERT(material_layout != NULL);
+    TEST_ASSERT(material_layout->size == 16 + 32 + 64 + 48);
+
+    glw::UniformBlock material(*material_layout, &error);
+    TEST_ASSERT(error == GL_NO_ERROR);
+    const GLint lit = 1;
+    const GLuint mask[2] = { 3, 5 };
+    const float skew[8] = { 1,2,3,4, 5,6,7,8 };
+    float r[16];
+    for(int i = 0; i < 16; ++i) r[i] = (float)i;
+    const float q[6] = { 1,2,3, 4,5,6 };
+    TEST_ASSERT(material.set("lit", lit) == GL_NO_ERROR);
+    TEST_ASSERT(material.set("mask", mask) == GL_NO_ERROR);
+    TEST_ASSERT(material.set("skew", skew) == GL_NO_ERROR);
+    TEST_ASSERT(material.set("r", r) == GL_NO_ERROR);
+    TEST_ASSERT(material.set("q", q) == GL_NO_ERROR);
+    TEST_ASSERT(material.flush() == GL_NO_ERROR);
+
+    GLuint material_data[40];
+    TEST_ASSERT(material.buffer().read(0, sizeof(material_data), material_data) == GL_NO_ERROR);
+    const float* material_floats = (const float*)material_data;
+    TEST_ASSERT(material_data[0] == 1 && material_data[2] == 3 && material_data[3] == 5);
+    TEST_ASSERT(memcmp(material_floats + 4, skew, sizeof(skew)) == 0);
+    TEST_ASSERT(material_floats[12] == 0 && material_floats[13] == 4 && material_floats[14] == 8 && material_floats[15] == 12);
+    TEST_ASSERT(material_floats[16] == 1 && material_floats[17] == 5);
+    TEST_ASSERT(material_floats[28] == 1 && material_floats[29] == 4);
+    TEST_ASSERT(material_floats[32] == 2 && material_floats[33] == 5);
+    TEST_ASSERT(material_floats[36] == 3 && material_floats[37] == 6);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#include "test.hpp"
+#include "glw_program.hpp"
+
+struct Vertex
+{
+    GLfloat position[3];
+    GLfloat texcoord[2];
+    GLubyte color[4];
+};
+
+typedef glw::VertexLayout<Vertex,
+    __GLW_VERTEX_FIELD(Vertex, position),
+    __GLW_VERTEX_FIELD(Vertex, texcoord),
+    __GLW_VERTEX_FIELD(Vertex, color)> Layout;
+
+static_assert(Layout::stride == 24, "stride");
+static_assert(Layout::fields == 3, "fields");
+
+int main()
+{
+    TEST_INIT();
+
+    const glw::VertexFormat* formats = Layout::formats();
+    TEST_ASSERT(formats[0].components == 3 && formats[0].type == GL_FLOAT && formats[0].offset == 0);
+    TEST_ASSERT(formats[1].components == 2 && formats[1].type == GL_FLOAT && formats[1].offset == 12);
+    TEST_ASSERT(formats[2].components == 4 && formats[2].type == GL_UNSIGNED_BYTE && formats[2].offset == 20);
+
+    const char* vsource = 
+        "#version 330\n"
+        "in vec3 v_position;"
+        "in vec2 v_texcoord;"
+        "out vec2 f_texcoord;"
+        "void main() { f_texcoord = v_texcoord; gl_Position = vec4(v_position, 1); }";
+    const char* fsource = 
+        "#version 330\n"
+        "in vec2 f_texcoord;"
+        "out vec4 f_color;"
+        "void main() { f_color = vec4(f_texcoord, 0, 1); }";
+
+    glw::Program::Shaders shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program program(shaders);
+    TEST_ASSERT(program.build() == GL_NO_ERROR);
+
+    const Vertex vertices[3] = {
+        { { 0, 0, 0 }, { 0, 0 }, { 255, 0, 0, 255 } },
+        { { 1, 0, 0 }, { 1, 0 }, { 0, 255, 0, 255 } },
+        { { 0, 1, 0 }, { 0, 1 }, { 0, 0, 255, 255 } } };
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glw::StateCache::current().invalidate();
+
+    // The unused color field is skipped.
+    const GLchar* names[Layout::fields] = { "v_position", "v_texcoord", "v_color" };
+    TEST_ASSERT(program.setAttributes<Layout>(names, buffer) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+
+    const GLint location = program.attributes()[program.attributeHandle("v_texcoord").index].location;
+    GLint value = 0;
+    void* pointer = NULL;
+    glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_SIZE, &value);
+    TEST_ASSERT(value == 2);
+    glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &value);
+    TEST_ASSERT(value == sizeof(Vertex));
+    glGetVertexAttribPointerv(location, GL_VERTEX_ATTRIB_ARRAY_POINTER, &pointer);
+    TEST_ASSERT(pointer == (void*)offsetof(Vertex, texcoord));
+
+    // Binding the same layout again reuses the vertex array.
+    TEST_ASSERT(program.setAttributes<Layout>(names, buffer) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+    TEST_ASSERT(program.vertexArrays() == 1);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "test.hpp"
+#include "glw_program.hpp"
+#include "glw_vertex_pack.hpp"
+
+struct Vertex
+{
+    glw::Half position[2];
+    GLshort texcoord[2];
+    glw::Int2101010 normal;
+    GLint index;
+};
+
+typedef glw::VertexLayout<Vertex,
+    __GLW_VERTEX_FIELD(Vertex, position),
+    __GLW_VERTEX_FIELD_NORMALIZED(Vertex, texcoord),
+    __GLW_VERTEX_FIELD_NORMALIZED(Vertex, normal),
+    __GLW_VERTEX_FIELD(Vertex, index)> Layout;
+
+int main()
+{
+    TEST_INIT();
+
+    // Halves, including rounding, denormals and overflow.
+    const GLfloat floats[7] = { 1.0f, -2.0f, 0.5f, 65504.0f, 1e6f, 5.960464e-8f, 1.00048828125f };
+    const GLushort halves[7] = { 0x3c00, 0xc000, 0x3800, 0x7bff, 0x7c00, 0x0001, 0x3c00 };
+    glw::Half packed[7];
+    glw::pack_half(floats, packed, 7);
+    for(int i = 0; i < 7; ++i) {
+        TEST_ASSERT(packed[i].bits == halves[i]);
+    }
+
+    // Normalized integers clamp, with the SIMD and scalar paths agreeing.
+    const GLfloat values[6] = { -2.0f, -1.0f, 0.0f, 0.5f, 1.0f, 2.0f };
+    GLbyte snorm8[6];
+    GLubyte unorm8[6];
+    GLshort snorm16[6];
+    GLushort unorm16[6];
+    glw::pack_snorm8(values, snorm8, 6);
+    glw::pack_unorm8(values, unorm8, 6);
+    glw::pack_snorm16(values, snorm16, 6);
+    glw::pack_unorm16(values, unorm16, 6);
+    TEST_ASSERT(snorm8[0] == -127 && snorm8[2] == 0 && snorm8[3] == 64 && snorm8[5] == 127);
+    TEST_ASSERT(snorm8[4] == 127 && snorm8[1] == -127);
+    TEST_ASSERT(unorm8[0] == 0 && unorm8[3] == 128 && unorm8[5] == 255);
+    TEST_ASSERT(snorm16[0] == -32767 && snorm16[5] == 32767 && snorm16[4] == 32767);
+    TEST_ASSERT(unorm16[0] == 0 && unorm16[4] == 65535 && unorm16[5] == 65535);
+
+    const GLfloat normal[4] = { 1.0f, -1.0f, 0.0f, 0.0f };
+    glw::Int2101010 normal_packed;
+    glw::pack_2_10_10_10(normal, &normal_packed, 1);
+    TEST_ASSERT(normal_packed.bits == (511u | (0x201u << 10)));
+
+    // Compact formats feed a program, integers unconverted.
+    const char* vsource = 
+        "#version 330\n"
+        "in vec2 v_position;"
+        "in vec2 v_texcoord;"
+        "in vec4 v_normal;"
+        "in int v_index;"
+        "flat out int f_index;"
+        "void main() { f_index = v_index; gl_Position = vec4(v_position + v_texcoord + v_normal.xy, 0, 1); }";
+    const char* fsource = 
+        "#version 330\n"
+        "flat in int f_index;"
+        "out vec4 f_color;"
+        "void main() { f_color = vec4(f_index); }";
+    glw::Program::Shaders shaders = {
+        { GL_VERTEX_SHADER, vsource },
+        { GL_FRAGMENT_SHADER, fsource } };
+    glw::Program program(shaders);
+    TEST_ASSERT(program.build() == GL_NO_ERROR);
+
+    Vertex vertices[3] = {};
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glw::StateCache::current().invalidate();
+
+    const GLchar* names[Layout::fields] = { "v_position", "v_texcoord", "v_normal", "v_index" };
+    TEST_ASSERT(program.setAttributes<Layout>(names, buffer) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+
+    GLint value = 0;
+    const GLint normal_location = program.attributes()[program.attributeHandle("v_normal").index].location;
+    glGetVertexAttribiv(normal_location, GL_VERTEX_ATTRIB_ARRAY_TYPE, &value);
+    TEST_ASSERT(value == GL_INT_2_10_10_10_REV);
+    glGetVertexAttribiv(normal_location, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &value);
+    TEST_ASSERT(value == GL_TRUE);
+    const GLint index_location = program.attributes()[program.attributeHandle("v_index").index].location;
+    glGetVertexAttribiv(index_location, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &value);
+    TEST_ASSERT(value == GL_TRUE);
+
+    // Formats can also be given per attribute.
+    const glw::VertexFormat half_format = { 2, GL_HALF_FLOAT, offsetof(Vertex, position), GL_FALSE };
+    TEST_ASSERT(program.setAttribute("v_position", buffer, sizeof(Vertex), half_format) == GL_NO_ERROR);
+    TEST_ASSERT(program.execute(GL_TRIANGLES, 0, 3) == GL_NO_ERROR);
+
+    return EXIT_SUCCESS;
+}